@@ -0,0 +1,430 @@
+#include "bound.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "spatial.h"
+
+// Neighbours of each customer in the candidate graph of the subgradient search
+#define BOUND_NEIGHBORS 10
+// Limit on iterations times customers, so the search stays short on large instances
+#define BOUND_BUDGET 5000000
+// Limit on the work of the q-route relaxation, in iterations times capacity times customers squared
+#define QROUTE_BUDGET 5e8
+// The q-route relaxation is skipped when fewer iterations fit in its budget
+#define QROUTE_MIN_ITERATIONS 20
+// The q-route search stops once its step factor is this small, later steps barely move the bound
+#define QROUTE_MIN_LAMBDA 1e-3
+
+typedef struct weighted_index {
+    float weight;
+    int index;
+} weighted_index;
+
+static int compare_ascending(const void* a, const void* b) {
+    float wa = ((weighted_index*)a)->weight, wb = ((weighted_index*)b)->weight;
+    return (wa > wb) - (wa < wb);
+}
+
+static int compare_caps(const void* a, const void* b) {
+    return *(int*)b - *(int*)a;
+}
+
+int cvrp_vehicles_bound(cvrp_data* data) {
+    int total_demand = 0;
+    for(int i = 0; i < data->n_nodes; i++) total_demand += data->nodes[i].demand;
+    if(!data->vehicle_caps) return (total_demand + data->cap - 1)/data->cap;
+
+    int caps[data->n_vehicles];
+    for(int i = 0; i < data->n_vehicles; i++) caps[i] = data->vehicle_caps[i];
+    qsort(caps, data->n_vehicles, sizeof(int), compare_caps);
+
+    int n_vehicles = 0;
+    for(int carried = 0; carried < total_demand && n_vehicles < data->n_vehicles; n_vehicles++) carried += caps[n_vehicles];
+    return n_vehicles;
+}
+
+// An edge between customers u and v
+// distance - the plain distance, weight - the distance with the penalties of both ends
+typedef struct bound_edge {
+    float weight;
+    float distance;
+    int u, v;
+} bound_edge;
+
+static int compare_edges_ascending(const void* a, const void* b) {
+    float wa = ((bound_edge*)a)->weight, wb = ((bound_edge*)b)->weight;
+    return (wa > wb) - (wa < wb);
+}
+
+static int compare_edges_descending(const void* a, const void* b) {
+    return compare_edges_ascending(b, a);
+}
+
+// Minimum spanning tree over the customers with penalized costs (Prim's algorithm)
+// The n-1 tree edges are stored in edges
+static void penalized_mst(cvrp_node* nodes, int n_nodes, float* pi, bound_edge* edges) {
+    bool in_tree[n_nodes];
+    float min_weight[n_nodes];
+    int parent[n_nodes];
+    for(int i = 0; i < n_nodes; i++) {
+        in_tree[i] = false;
+        min_weight[i] = INFINITY;
+        parent[i] = -1;
+    }
+
+    min_weight[0] = 0;
+    int n_edges = 0;
+    for(int step = 0; step < n_nodes; step++) {
+        int u = -1;
+        for(int i = 0; i < n_nodes; i++) {
+            if(!in_tree[i] && (u == -1 || min_weight[i] < min_weight[u])) u = i;
+        }
+        in_tree[u] = true;
+        if(parent[u] != -1) edges[n_edges++] = (bound_edge){.weight = min_weight[u], .u = parent[u], .v = u};
+
+        for(int v = 0; v < n_nodes; v++) {
+            if(in_tree[v]) continue;
+            float weight = cvrp_distance(nodes[u], nodes[v]) + pi[u] + pi[v];
+            if(weight < min_weight[v]) {
+                min_weight[v] = weight;
+                parent[v] = u;
+            }
+        }
+    }
+}
+
+static int find_root(int* root, int i) {
+    while(root[i] != i) i = root[i] = root[root[i]];
+    return i;
+}
+
+// Spanning tree over the candidate graph with penalized costs (Kruskal's algorithm)
+// If the graph is not connected its components are chained in index order, so the tree
+// always has n-1 edges, stored in edges. It is not minimal over the complete graph:
+// it is only used to choose the penalties, never as the bound itself
+static void penalized_sparse_tree(cvrp_node* nodes, int n_nodes, float* pi, bound_edge* graph, int n_graph, bound_edge* edges) {
+    for(int i = 0; i < n_graph; i++) graph[i].weight = graph[i].distance + pi[graph[i].u] + pi[graph[i].v];
+    qsort(graph, n_graph, sizeof(bound_edge), compare_edges_ascending);
+
+    int root[n_nodes];
+    for(int i = 0; i < n_nodes; i++) root[i] = i;
+
+    int n_edges = 0;
+    for(int i = 0; i < n_graph && n_edges < n_nodes-1; i++) {
+        int ru = find_root(root, graph[i].u), rv = find_root(root, graph[i].v);
+        if(ru == rv) continue;
+        root[ru] = rv;
+        edges[n_edges++] = graph[i];
+    }
+
+    int last = -1;
+    for(int i = 0; i < n_nodes && n_edges < n_nodes-1; i++) {
+        if(find_root(root, i) != i) continue;
+        if(last != -1) {
+            float distance = cvrp_distance(nodes[last], nodes[i]);
+            edges[n_edges++] = (bound_edge){.weight = distance + pi[last] + pi[i], .distance = distance, .u = last, .v = i};
+        }
+        last = i;
+    }
+}
+
+// Value of the relaxation for the given tree and penalties, minimized over the number of routes
+// With k routes the k-1 heaviest tree edges are dropped and the k cheapest depot edges are used twice
+// edges - the n-1 tree edges, sorted by the caller from the heaviest
+// routes - set to the number of routes of the minimum
+static float relaxation_value(cvrp_data* data, float* pi, bound_edge* edges, weighted_index* depot_edges, int min_routes, int max_routes, int* routes) {
+    int n = data->n_nodes;
+    for(int i = 0; i < n; i++) depot_edges[i] = (weighted_index){.weight = cvrp_distance(data->depot, data->nodes[i]) + pi[i], .index = i};
+    qsort(depot_edges, n, sizeof(weighted_index), compare_ascending);
+
+    float penalty = 0;
+    for(int i = 0; i < n; i++) penalty += 2*pi[i];
+
+    float forest = 0;
+    for(int i = 0; i < n-1; i++) forest += edges[i].weight;
+    float depot = 0;
+    for(int i = 0; i < min_routes-1; i++) forest -= edges[i].weight;
+    for(int i = 0; i < min_routes; i++) depot += 2*depot_edges[i].weight;
+
+    float value = forest + depot - penalty;
+    *routes = min_routes;
+    for(int k = min_routes+1; k <= max_routes; k++) {
+        forest -= edges[k-2].weight;
+        depot += 2*depot_edges[k-1].weight;
+        if(forest + depot - penalty < value) {
+            value = forest + depot - penalty;
+            *routes = k;
+        }
+    }
+    return value;
+}
+
+// Exact value of the relaxation, over the complete graph
+static float exact_value(cvrp_data* data, float* pi, bound_edge* edges, weighted_index* depot_edges, int min_routes, int max_routes) {
+    int routes;
+    penalized_mst(data->nodes, data->n_nodes, pi, edges);
+    qsort(edges, data->n_nodes-1, sizeof(bound_edge), compare_edges_descending);
+    return relaxation_value(data, pi, edges, depot_edges, min_routes, max_routes, &routes);
+}
+
+// The two cheapest paths from the depot to a customer with a given load, which reach the
+// customer from different predecessors, so that a path never goes back to where it came from
+// cost - the distance minus the penalty of every visit
+// pred - the previous customer, -1 for the depot
+// rank - which of the two paths of pred it extends
+typedef struct qpath {
+    float cost[2];
+    int pred[2];
+    int rank[2];
+} qpath;
+
+// Value of the q-route relaxation for the penalties pi (Christofides, Mingozzi and Toth)
+// Routes may visit a customer several times as long as their load is at most cap, and
+// the cheapest set of such routes whose loads add up to the total demand is chosen
+// paths - (cap+1)*n work items, paths[q*n+v] being the paths to v with load q
+// route_cost, route_end - cap+1 items, the cheapest route with each load and its last customer
+// total, choice - total_demand+1 items, the cheapest routes with each total load and the load of the last one
+// visits - set to the number of visits of every customer in the chosen routes
+static float qroute_value(cvrp_data* data, int cap, int total_demand, float* distances, float* pi,
+                          qpath* paths, float* route_cost, int* route_end, float* total, int* choice, int* visits) {
+    int n = data->n_nodes;
+    cvrp_node* nodes = data->nodes;
+
+    for(int q = 0; q <= cap; q++) {
+        for(int v = 0; v < n; v++) {
+            qpath* path = &paths[q*n + v];
+            *path = (qpath){.cost = {INFINITY, INFINITY}, .pred = {-1, -1}, .rank = {0, 0}};
+            int demand = nodes[v].demand;
+            if(demand > q) continue;
+            if(demand == q) {
+                path->cost[0] = cvrp_distance(data->depot, nodes[v]) - pi[v];
+                continue;
+            }
+            for(int u = 0; u < n; u++) {
+                if(u == v) continue;
+                qpath* from = &paths[(q-demand)*n + u];
+                // extending the best path to u would go back to v right away
+                int rank = from->pred[0] == v ? 1 : 0;
+                float cost = from->cost[rank] + distances[u*n + v] - pi[v];
+                // every u is tried once, so both paths always have different predecessors
+                if(cost < path->cost[0]) {
+                    path->cost[1] = path->cost[0];
+                    path->pred[1] = path->pred[0];
+                    path->rank[1] = path->rank[0];
+                    path->cost[0] = cost;
+                    path->pred[0] = u;
+                    path->rank[0] = rank;
+                } else if(cost < path->cost[1]) {
+                    path->cost[1] = cost;
+                    path->pred[1] = u;
+                    path->rank[1] = rank;
+                }
+            }
+        }
+    }
+
+    for(int q = 1; q <= cap; q++) {
+        route_cost[q] = INFINITY;
+        for(int v = 0; v < n; v++) {
+            float cost = paths[q*n + v].cost[0] + cvrp_distance(nodes[v], data->depot);
+            if(cost < route_cost[q]) {
+                route_cost[q] = cost;
+                route_end[q] = v;
+            }
+        }
+    }
+
+    total[0] = 0;
+    for(int d = 1; d <= total_demand; d++) {
+        total[d] = INFINITY;
+        for(int q = 1; q <= cap && q <= d; q++) {
+            if(total[d-q] + route_cost[q] < total[d]) {
+                total[d] = total[d-q] + route_cost[q];
+                choice[d] = q;
+            }
+        }
+    }
+
+    // walk the chosen routes back to count the visits
+    for(int i = 0; i < n; i++) visits[i] = 0;
+    for(int d = total_demand; d > 0; d -= choice[d]) {
+        int load = choice[d], v = route_end[load], rank = 0;
+        while(v != -1) {
+            visits[v]++;
+            qpath* path = &paths[load*n + v];
+            load -= nodes[v].demand;
+            v = path->pred[rank];
+            rank = path->rank[rank];
+        }
+    }
+
+    float value = total[total_demand];
+    for(int i = 0; i < n; i++) value += pi[i];
+    return value;
+}
+
+// Lagrangian bound from the q-route relaxation, the penalties push every customer towards
+// one visit with subgradient optimization
+// Returns 0 when it does not fit in QROUTE_BUDGET or a demand is not between 1 and the capacity
+static float qroute_bound(cvrp_data* data, int iterations, float upper_bound) {
+    int n = data->n_nodes;
+    cvrp_node* nodes = data->nodes;
+
+    // without a route count the largest vehicle can be used for every route
+    int cap = data->cap;
+    for(int i = 0; data->vehicle_caps && i < data->n_vehicles; i++) {
+        if(i == 0 || data->vehicle_caps[i] > cap) cap = data->vehicle_caps[i];
+    }
+    int total_demand = 0;
+    for(int i = 0; i < n; i++) {
+        if(nodes[i].demand < 1 || nodes[i].demand > cap) return 0;
+        total_demand += nodes[i].demand;
+    }
+
+    double work = (double)cap*n*n + (double)total_demand*cap;
+    if(iterations > QROUTE_BUDGET/work) iterations = QROUTE_BUDGET/work;
+    if(iterations < QROUTE_MIN_ITERATIONS) return 0;
+
+    float* distances = malloc((size_t)n*n*sizeof(float));
+    for(int u = 0; u < n; u++) {
+        for(int v = 0; v < n; v++) distances[u*n + v] = cvrp_distance(nodes[u], nodes[v]);
+    }
+    qpath* paths = malloc((size_t)(cap+1)*n*sizeof(qpath));
+    float* route_cost = malloc((cap+1)*sizeof(float));
+    int* route_end = malloc((cap+1)*sizeof(int));
+    float* total = malloc((total_demand+1)*sizeof(float));
+    int* choice = malloc((total_demand+1)*sizeof(int));
+    int* visits = malloc(n*sizeof(int));
+    float* pi = malloc(n*sizeof(float));
+    for(int i = 0; i < n; i++) pi[i] = 0;
+
+    float best_value = 0;
+    float lambda = 2;
+    int stall = 0;
+    for(int it = 0; it < iterations; it++) {
+        float value = qroute_value(data, cap, total_demand, distances, pi, paths, route_cost, route_end, total, choice, visits);
+        if(value > best_value) {
+            best_value = value;
+            stall = 0;
+        } else if(++stall >= 10) {
+            lambda /= 2;
+            stall = 0;
+            if(lambda < QROUTE_MIN_LAMBDA) break;
+        }
+
+        // subgradient: how far each customer is from one visit
+        float norm = 0;
+        for(int i = 0; i < n; i++) norm += (1-visits[i])*(1-visits[i]);
+        if(norm == 0) break;
+
+        float target = 1.05f*best_value < upper_bound ? 1.05f*best_value : upper_bound;
+        float step = lambda*(target - value)/norm;
+        for(int i = 0; i < n; i++) pi[i] += step*(1-visits[i]);
+    }
+
+    free(distances);
+    free(paths);
+    free(route_cost);
+    free(route_end);
+    free(total);
+    free(choice);
+    free(visits);
+    free(pi);
+    return best_value;
+}
+
+float cvrp_distance_bound(cvrp_data* data, int iterations) {
+    int n = data->n_nodes;
+    cvrp_node* nodes = data->nodes;
+    if(n == 0) return 0;
+
+    int min_routes = cvrp_vehicles_bound(data);
+    if(min_routes < 1) min_routes = 1;
+    if(min_routes > n) min_routes = n;
+    int max_routes = data->n_vehicles < n ? data->n_vehicles : n;
+    if(max_routes < min_routes) max_routes = min_routes;
+    int qroute_iterations = iterations;
+    if(iterations > BOUND_BUDGET/n) iterations = BOUND_BUDGET/n;
+
+    // candidate graph: every customer linked to its nearest neighbours
+    cvrp_grid* grid = data->grid ? data->grid : cvrp_grid_create(nodes, NULL, n, n);
+    bound_edge* graph = malloc(n*BOUND_NEIGHBORS*sizeof(bound_edge));
+    int n_graph = 0;
+    for(int i = 0; i < n; i++) {
+        int neighbors[BOUND_NEIGHBORS+1];
+        int n_neighbors = cvrp_grid_knearest(grid, nodes[i].x, nodes[i].y, BOUND_NEIGHBORS+1, neighbors);
+        for(int j = 0; j < n_neighbors && n_graph < (i+1)*BOUND_NEIGHBORS; j++) {
+            if(neighbors[j] == i) continue;
+            graph[n_graph++] = (bound_edge){.distance = cvrp_distance(nodes[i], nodes[neighbors[j]]), .u = i, .v = neighbors[j]};
+        }
+    }
+    if(grid != data->grid) cvrp_grid_free(grid);
+
+    float pi[n];
+    float best_pi[n];
+    int degree[n];
+    bound_edge* edges = malloc((n > 1 ? n-1 : 1)*sizeof(bound_edge));
+    weighted_index* depot_edges = malloc(n*sizeof(weighted_index));
+
+    // the star solution (one route per customer) bounds the optimum from above
+    float upper_bound = 0;
+    for(int i = 0; i < n; i++) {
+        pi[i] = 0;
+        best_pi[i] = 0;
+        upper_bound += 2*cvrp_distance(data->depot, nodes[i]);
+    }
+
+    // subgradient search for the penalties on the sparse tree
+    float best_value = 0;
+    float lambda = 2;
+    int stall = 0;
+    for(int it = 0; it < iterations; it++) {
+        int routes;
+        penalized_sparse_tree(nodes, n, pi, graph, n_graph, edges);
+        qsort(edges, n-1, sizeof(bound_edge), compare_edges_descending);
+        float value = relaxation_value(data, pi, edges, depot_edges, min_routes, max_routes, &routes);
+
+        if(value > best_value) {
+            best_value = value;
+            for(int i = 0; i < n; i++) best_pi[i] = pi[i];
+            stall = 0;
+        } else if(++stall >= 10) {
+            lambda /= 2;
+            stall = 0;
+        }
+
+        // subgradient: how far each customer is from degree 2
+        for(int i = 0; i < n; i++) degree[i] = 0;
+        for(int i = routes-1; i < n-1; i++) {
+            degree[edges[i].u]++;
+            degree[edges[i].v]++;
+        }
+        for(int i = 0; i < routes; i++) degree[depot_edges[i].index] += 2;
+
+        float norm = 0;
+        for(int i = 0; i < n; i++) norm += (degree[i]-2)*(degree[i]-2);
+        if(norm == 0) break;
+
+        // aim slightly above the best value, but never above a known feasible cost
+        float target = 1.05f*best_value < upper_bound ? 1.05f*best_value : upper_bound;
+        float step = lambda*(target - value)/norm;
+        for(int i = 0; i < n; i++) pi[i] += step*(degree[i]-2);
+    }
+
+    // the sparse tree may be heavier than the minimum one, so the bound is evaluated
+    // over the complete graph, with the best penalties found and without penalties
+    for(int i = 0; i < n; i++) pi[i] = 0;
+    float bound = exact_value(data, pi, edges, depot_edges, min_routes, max_routes);
+    float penalized = exact_value(data, best_pi, edges, depot_edges, min_routes, max_routes);
+    if(penalized > bound) bound = penalized;
+
+    // the forest ignores the capacities beyond the number of routes, the q-routes do not
+    float qroute = qroute_bound(data, qroute_iterations, upper_bound);
+    if(qroute > bound) bound = qroute;
+
+    free(graph);
+    free(edges);
+    free(depot_edges);
+    return bound;
+}
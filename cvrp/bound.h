@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cvrp.h"
+
+// Minimum number of vehicles needed to carry the total demand
+// With a heterogeneous fleet the largest vehicles are counted first
+int cvrp_vehicles_bound(cvrp_data* data);
+
+// Lagrangian lower bound on the total distance (Held-Karp style)
+// The routes are relaxed to a spanning forest of the customers with one tree per route,
+// plus two depot edges per route; the degree of every customer is then pushed towards 2
+// with subgradient optimization. The bound is taken over every number of routes between
+// cvrp_vehicles_bound and data->n_vehicles
+// The penalties are searched on a sparse graph linking every customer to its nearest
+// neighbours (from data->grid if set), then the bound is evaluated once over the complete graph
+// The forest only accounts for the capacities through the number of routes, so the q-route
+// relaxation is also solved when it fits in its budget (capacity times customers squared per
+// iteration): routes of load at most the capacity that may revisit customers, but never right
+// after leaving them, with penalties pushing every customer towards one visit. The larger of
+// the two bounds is returned
+// iterations - the maximum number of subgradient iterations (fewer on large instances)
+float cvrp_distance_bound(cvrp_data* data, int iterations);
@@ -6,6 +6,10 @@
 #include <math.h>
 
 #include "grasp.h"
+#include "grasp_inline.h"
+#include "spatial.h"
+#include "bound.h"
+#include "segment.h"
 
 float random_real() {
     return (float)rand()/RAND_MAX;
@@ -77,6 +81,7 @@ float cvrp_total_cost(cvrp_route* routes, int n_routes, cvrp_node* nodes, cvrp_n
     float total_cost = 0;
     for(int i = 0; i < n_routes; i++) {
         cvrp_route route = routes[i];
+        if(route.length == 0) continue;
         cvrp_node first_node = nodes[route.stops[0]];
         cvrp_node last_node = nodes[route.stops[route.length-1]];
         total_cost += cvrp_distance(depot, first_node) + cvrp_distance(last_node, depot);
@@ -101,31 +106,50 @@ bool cvrp_feasable(cvrp_route* routes, int n_routes, cvrp_node* nodes, int cap)
     return true;
 }
 
-void _cvrp_costs(grasp* g, void* v_nodes, int n_nodes, int* solution, int n_solution, float* costs) {
-	cvrp_node* nodes = (cvrp_node*) v_nodes;
-    cvrp_data* data = (cvrp_data*) g->data;
+// The cost used by the search
+// variant is a compile-time constant: plain CVRP instances keep the original cost,
+// instances with a heterogeneous fleet or time windows use the segment evaluation
+GRASP_INLINE float solution_cost(cvrp_route* routes, int n_routes, cvrp_data* data, const bool variant) {
+    if(variant) return cvrp_variant_cost(routes, n_routes, data);
+    return cvrp_total_cost(routes, n_routes, data->nodes, data->depot);
+}
+
+// The cost of the route served by the given vehicle, the cost of a solution is the sum over its routes
+GRASP_INLINE float route_cost(cvrp_route route, int vehicle, cvrp_data* data, const bool variant) {
+    if(variant) return cvrp_segment_cost(cvrp_route_segment(data, route), cvrp_vehicle_cap(data, vehicle));
+    return cvrp_total_cost(&route, 1, data->nodes, data->depot);
+}
+
+// Store the cost of every route in route_costs and return their sum
+// The moves keep these costs, a move only changes one route, so only that route is evaluated again
+GRASP_INLINE float routes_cost(cvrp_route* routes, int n_routes, cvrp_data* data, float* route_costs, const bool variant) {
+    float total_cost = 0;
+    for(int i = 0; i < n_routes; i++) {
+        route_costs[i] = route_cost(routes[i], i, data, variant);
+        total_cost += route_costs[i];
+    }
+    return total_cost;
+}
 
+// Only the candidates found by _cvrp_candidates are evaluated, the other costs are not used
+// The capacity is the one of the vehicle that the split will fill with the last stop
+GRASP_INLINE void _cvrp_costs(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int n_solution, float* costs) {
+    int cap = cvrp_vehicle_cap(data, data->_vehicle);
     cvrp_node node_i;
     if(n_solution > 0) node_i = nodes[solution[n_solution-1]];
     else if(n_solution == 0) node_i = data->depot;
 
-	for (int j = 0; j < n_nodes; j++) {
-        if(n_solution > 0 && solution[n_solution-1] == j) {
-            costs[j] = 0;
-        } else {
-            cvrp_node node_j = nodes[j];
-            
-            float distance = node_i.x == node_j.x && node_i.y == node_j.y ? 1e-3 : cvrp_distance(node_i, node_j);
-            float distance_depot_j = data->depot.x == node_j.x && data->depot.y == node_j.y ? 1e-3 : cvrp_distance(data->depot, node_j);
-            costs[j] = (data->cap - (node_j.demand + node_i.demand))/(pow(distance*distance_depot_j, 2));
-        }
+	for (int k = 0; k < data->_n_neighbors; k++) {
+        int j = data->_neighbors[k];
+        cvrp_node node_j = nodes[j];
+
+        float distance = node_i.x == node_j.x && node_i.y == node_j.y ? 1e-3 : cvrp_distance(node_i, node_j);
+        float distance_depot_j = data->depot.x == node_j.x && data->depot.y == node_j.y ? 1e-3 : cvrp_distance(data->depot, node_j);
+        costs[j] = (cap - (node_j.demand + node_i.demand))/(pow(distance*distance_depot_j, 2));
     }
 }
 
-void _cvrp_compare(grasp* g, void* v_nodes, int* sol, int n_sol, int* best, int* n_best, bool first_solution) {
-	cvrp_node* nodes = (cvrp_node*) v_nodes;
-	cvrp_data* data = (cvrp_data*) g->data;
-
+GRASP_INLINE void compare_impl(grasp* g, cvrp_data* data, cvrp_node* nodes, int* sol, int n_sol, int* best, int* n_best, bool first_solution, const bool variant) {
     if(first_solution) {
         for(int i = 0; i < n_sol; i++) best[i] = sol[i];
 		*n_best = n_sol;
@@ -136,14 +160,17 @@ void _cvrp_compare(grasp* g, void* v_nodes, int* sol, int n_sol, int* best, int*
     }
 
     cvrp_route* current_routes = indices_to_routes(sol, data->_routes_indices, data->n_vehicles);
-    float current_cost = cvrp_total_cost(current_routes, data->n_vehicles, nodes, data->depot);
+    float current_cost = solution_cost(current_routes, data->n_vehicles, data, variant);
+    bool current_feasible = cvrp_solution_feasible(current_routes, data->n_vehicles, data);
     routes_to_indices(current_routes, data->n_vehicles, sol, data->_routes_indices);
 
     cvrp_route* best_routes = indices_to_routes(best, data->_best_routes_indices, data->n_vehicles);
-    float best_cost = cvrp_total_cost(best_routes, data->n_vehicles, nodes, data->depot);
+    float best_cost = solution_cost(best_routes, data->n_vehicles, data, variant);
+    bool best_feasible = cvrp_solution_feasible(best_routes, data->n_vehicles, data);
     routes_to_indices(best_routes, data->n_vehicles, best, data->_best_routes_indices);
 
-    if(current_cost < best_cost) {
+    // a feasible solution is kept over an infeasible one, whatever their costs
+    if(current_feasible != best_feasible ? current_feasible : current_cost < best_cost) {
         for(int i = 0; i < n_sol; i++) best[i] = sol[i];
 		*n_best = n_sol;
         for(int i = 0; i < data->n_vehicles; i++) data->_best_routes_indices[i] = data->_routes_indices[i];
@@ -152,19 +179,60 @@ void _cvrp_compare(grasp* g, void* v_nodes, int* sol, int n_sol, int* best, int*
     for(int i = 0; i < data->n_vehicles; i++) data->_routes_indices[i] = data->_best_routes_indices[i];
 }
 
-void _cvrp_candidates(grasp* g, void* v_nodes, int n_nodes, int* solution, int n_solution, bool* candidates) {
-	cvrp_node* nodes = (cvrp_node*) v_nodes;
-	cvrp_data* data = (cvrp_data*) g->data;
+GRASP_INLINE void _cvrp_compare(grasp* g, cvrp_data* data, cvrp_node* nodes, int* sol, int n_sol, int* best, int* n_best, bool first_solution) {
+    compare_impl(g, data, nodes, sol, n_sol, best, n_best, first_solution, false);
+}
+
+GRASP_INLINE void _cvrp_variant_compare(grasp* g, cvrp_data* data, cvrp_node* nodes, int* sol, int n_sol, int* best, int* n_best, bool first_solution) {
+    compare_impl(g, data, nodes, sol, n_sol, best, n_best, first_solution, true);
+}
+
+GRASP_INLINE float evaluate_impl(grasp* g, cvrp_data* data, cvrp_node* nodes, int* best, int n_best, const bool variant) {
+    cvrp_route* best_routes = indices_to_routes(best, data->_best_routes_indices, data->n_vehicles);
+    float best_cost = solution_cost(best_routes, data->n_vehicles, data, variant);
+    routes_to_indices(best_routes, data->n_vehicles, best, data->_best_routes_indices);
+    return best_cost;
+}
+
+GRASP_INLINE float _cvrp_evaluate(grasp* g, cvrp_data* data, cvrp_node* nodes, int* best, int n_best) {
+    return evaluate_impl(g, data, nodes, best, n_best, false);
+}
 
-	for (int i = 0; i < n_solution; i++) {
-		candidates[solution[i]] = false;
-	}
+GRASP_INLINE float _cvrp_variant_evaluate(grasp* g, cvrp_data* data, cvrp_node* nodes, int* best, int n_best) {
+    return evaluate_impl(g, data, nodes, best, n_best, true);
 }
 
-void _cvrp_split(grasp* g, void* v_nodes, int n_nodes, int* solution, int n_solution) {
-    cvrp_node* nodes = (cvrp_node*) v_nodes;
-	cvrp_data* data = (cvrp_data*) g->data;
+// The candidates are the CVRP_CANDIDATES unvisited nodes nearest to the last stop
+// Visited nodes are removed from the instance grid as the construction goes
+// The engine is given the same list as its candidate_indices, so a step does not scan every node
+GRASP_INLINE void _cvrp_candidates(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int n_solution, bool* candidates) {
+    cvrp_node last_stop;
+    if(n_solution == 0) {
+        cvrp_grid_reset(data->grid);
+        last_stop = data->depot;
+        for (int i = 0; i < n_nodes; i++) candidates[i] = false;
+        data->_vehicle = 0;
+        data->_load = 0;
+    } else {
+        cvrp_grid_remove(data->grid, solution[n_solution-1]);
+        last_stop = nodes[solution[n_solution-1]];
+        // only the previous candidates can still be set
+        for (int k = 0; k < data->_n_neighbors; k++) candidates[data->_neighbors[k]] = false;
+        // follow the vehicles in the order the split fills them
+        data->_load += last_stop.demand;
+        if(data->_load > cvrp_vehicle_cap(data, data->_vehicle) && data->_vehicle < data->n_vehicles-1) {
+            data->_vehicle++;
+            data->_load = last_stop.demand;
+        }
+    }
 
+    data->_n_neighbors = cvrp_grid_knearest(data->grid, last_stop.x, last_stop.y, CVRP_CANDIDATES, data->_neighbors);
+    for (int k = 0; k < data->_n_neighbors; k++) candidates[data->_neighbors[k]] = true;
+    g->candidate_indices = data->_neighbors;
+    g->n_candidate_indices = data->_n_neighbors;
+}
+
+GRASP_INLINE void split_impl(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int n_solution, const bool variant) {
     int n_vehicles = data->n_vehicles;
     int cap = data->cap;
     cvrp_node depot = data->depot;
@@ -174,7 +242,7 @@ void _cvrp_split(grasp* g, void* v_nodes, int n_nodes, int* solution, int n_solu
     int route_index = 0;
 
     for(int i = 0; i < n_vehicles; i++) {
-        int limit = cap;
+        int limit = variant ? cvrp_vehicle_cap(data, i) : cap;
         for(int j = 0; j < n_solution; j++) {
             if(visited[j]) continue;
             cvrp_node current_node = nodes[solution[j]];
@@ -194,38 +262,17 @@ void _cvrp_split(grasp* g, void* v_nodes, int n_nodes, int* solution, int n_solu
         }
     }
 
-    // apply the nearest-neighbor heuristic
-    cvrp_route* routes = indices_to_routes(split_solution, data->_routes_indices, n_vehicles);
-    for(int i = 0; i < n_vehicles; i++) {
-        cvrp_route* route = &routes[i];
-        bool visited[route->length]; for(int j = 0; j < route->length; j++) visited[j] = false;
-        int new_stops[route->length];
-
-        cvrp_node last_stop = data->depot;
-        for(int j = 0; j < route->length; j++) {
-            // find nearest node to last_node
-            cvrp_node nearest; int nearest_index;
-            float min_distance = INFINITY;
-            for(int k = 0; k < route->length; k++) {
-                if(visited[k]) continue;
-                cvrp_node current = nodes[route->stops[k]];
-                float distance = cvrp_distance(last_stop, current);
-                if(distance < min_distance) {
-                    nearest = current;
-                    min_distance = distance;
-                    nearest_index = k;
-                }
-            }
-            last_stop = nearest;
-            visited[nearest_index] = true;
-            new_stops[j] = solution[route->stops[nearest_index]];
-        }
-        for(int j = 0; j < route->length; j++) route->stops[j] = new_stops[j];
-    }
-
     for(int i = 0; i < n_solution; i++) solution[i] = split_solution[i];
 }
 
+GRASP_INLINE void _cvrp_split(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int n_solution) {
+    split_impl(g, data, nodes, n_nodes, solution, n_solution, false);
+}
+
+GRASP_INLINE void _cvrp_variant_split(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int n_solution) {
+    split_impl(g, data, nodes, n_nodes, solution, n_solution, true);
+}
+
 void swap_nodes(cvrp_route route, int i, int j) {
     int aux = route.stops[i];
     route.stops[i] = route.stops[j];
@@ -264,12 +311,14 @@ void splice(cvrp_route* route_a, cvrp_route* route_b, int a, int b) {
     route_b->length = new_length_b;
 }
 
-cvrp_route* best_swap_neighbor(cvrp_route* original_routes, int n_routes, int cap, cvrp_node* nodes, cvrp_node depot, float temperature, float* best_cost) {
+GRASP_INLINE cvrp_route* best_swap_neighbor(cvrp_route* original_routes, int n_routes, cvrp_data* data, float temperature, float* best_cost, const bool variant) {
     cvrp_route* routes = copy_routes(original_routes, n_routes);
+    float route_costs[n_routes];
+    float current_cost = routes_cost(routes, n_routes, data, route_costs, variant);
 
     for(int i = 0; i < n_routes; i++) {
         cvrp_route route = routes[i];
-        if(route.length == 1) continue;
+        if(route.length <= 1) continue;
 
         int a = rand()%(route.length);
         int b = rand()%(route.length);
@@ -278,27 +327,31 @@ cvrp_route* best_swap_neighbor(cvrp_route* original_routes, int n_routes, int ca
         }
 
         swap_nodes(route, a, b);
-        float cost = cvrp_total_cost(routes, n_routes, nodes, depot);
+        float new_route_cost = route_cost(route, i, data, variant);
+        float cost = current_cost - route_costs[i] + new_route_cost;
 
         float delta_cost = *best_cost - cost;
         if(cost < *best_cost) {
             *best_cost = cost;
-        } else if (exp((delta_cost)/temperature) > random_real()) {
-            continue;
-        } else {
+        } else if (!(exp((delta_cost)/temperature) > random_real())) {
             swap_nodes(route, a, b);
+            continue;
         }
+        current_cost = cost;
+        route_costs[i] = new_route_cost;
     }
 
     return routes;
 }
 
-cvrp_route* best_invert_neighbor(cvrp_route* original_routes, int n_routes, int cap, cvrp_node* nodes, cvrp_node depot, float temperature, float* best_cost) {
+GRASP_INLINE cvrp_route* best_invert_neighbor(cvrp_route* original_routes, int n_routes, cvrp_data* data, float temperature, float* best_cost, const bool variant) {
     cvrp_route* routes = copy_routes(original_routes, n_routes);
+    float route_costs[n_routes];
+    float current_cost = routes_cost(routes, n_routes, data, route_costs, variant);
 
     for(int i = 0; i < n_routes; i++) {
         cvrp_route route = routes[i];
-        if(route.length == 1) continue;
+        if(route.length <= 1) continue;
 
         int a = rand()%(route.length);
         int b = rand()%(route.length);
@@ -307,23 +360,27 @@ cvrp_route* best_invert_neighbor(cvrp_route* original_routes, int n_routes, int
         }
 
         invert_nodes(route, a, b);
-        float cost = cvrp_total_cost(routes, n_routes, nodes, depot);
+        float new_route_cost = route_cost(route, i, data, variant);
+        float cost = current_cost - route_costs[i] + new_route_cost;
 
         float delta_cost = *best_cost - cost;
         if(cost < *best_cost) {
             *best_cost = cost;
-        } else if (exp((delta_cost)/temperature) > random_real()) {
-            continue;
-        } else {
+        } else if (!(exp((delta_cost)/temperature) > random_real())) {
             invert_nodes(route, a, b);
+            continue;
         }
+        current_cost = cost;
+        route_costs[i] = new_route_cost;
     }
 
     return routes;
 }
 
-cvrp_route* best_intra2opt_neighbor(cvrp_route* original_routes, int n_routes, int cap, cvrp_node* nodes, cvrp_node depot, float temperature, float* best_cost) {
+GRASP_INLINE cvrp_route* best_intra2opt_neighbor(cvrp_route* original_routes, int n_routes, cvrp_data* data, float temperature, float* best_cost, const bool variant) {
     cvrp_route* routes = copy_routes(original_routes, n_routes);
+    float route_costs[n_routes];
+    float current_cost = routes_cost(routes, n_routes, data, route_costs, variant);
 
     for(int i = 0; i < n_routes; i++) {
         for(int j = 0; j < 10; j++) {
@@ -343,92 +400,160 @@ cvrp_route* best_intra2opt_neighbor(cvrp_route* original_routes, int n_routes, i
             }
             swap_nodes(route, a+1, b);
             invert_nodes(route, a+2, b-1);
-            float cost = cvrp_total_cost(routes, n_routes, nodes, depot);
+            float new_route_cost = route_cost(route, i, data, variant);
+            float cost = current_cost - route_costs[i] + new_route_cost;
 
             float delta_cost = *best_cost - cost;
             if(cost < *best_cost) {
                 *best_cost = cost;
-            } else if (exp((delta_cost)/temperature) > random_real()) {
-                continue;
-            } else {
+            } else if (!(exp((delta_cost)/temperature) > random_real())) {
                 invert_nodes(route, a+2, b-1);
                 swap_nodes(route, a+1, b);
+                continue;
             }
+            current_cost = cost;
+            route_costs[i] = new_route_cost;
         }
     }
 
     return routes;
 }
 
-cvrp_route* best_2opt_neighbor(cvrp_route* original_routes, int n_routes, int cap, cvrp_node* nodes, cvrp_node depot, float temperature, float* best_cost) {
+// The cost of a route from its segment, see route_cost
+GRASP_INLINE float segment_cost(cvrp_segment segment, int vehicle, cvrp_data* data, const bool variant) {
+    if(variant) return cvrp_segment_cost(segment, cvrp_vehicle_cap(data, vehicle));
+    return segment.distance;
+}
+
+// Inter-route 2-opt: route i keeps its stops up to a and goes on with the stops of route j
+// after b, while route j keeps its stops up to b and goes on with the stops of route i after a.
+// The stop that follows a is picked among the nearest neighbours of a, so the new edge is short.
+// Each splice is evaluated in O(1) from the prefix and suffix segments of both routes,
+// and only the accepted ones are applied
+GRASP_INLINE cvrp_route* best_2opt_neighbor(cvrp_route* original_routes, int n_routes, cvrp_data* data, float temperature, float* best_cost, const bool variant) {
     cvrp_route* routes = copy_routes(original_routes, n_routes);
     bool spliced[n_routes]; for(int i = 0; i < n_routes; i++) spliced[i] = false;
 
+    // the route of every stop and its position in it
+    int route_of[data->n_nodes];
+    int position_of[data->n_nodes];
+
+    cvrp_segment* prefix[n_routes];
+    cvrp_segment* suffix[n_routes];
+    float route_costs[n_routes];
+    float current_cost = 0;
+    for(int i = 0; i < n_routes; i++) {
+        prefix[i] = malloc((routes[i].length+1)*sizeof(cvrp_segment));
+        suffix[i] = malloc((routes[i].length+1)*sizeof(cvrp_segment));
+        cvrp_route_segments(data, routes[i], prefix[i], suffix[i]);
+        route_costs[i] = segment_cost(cvrp_segment_concat(data, prefix[i][0], suffix[i][0]), i, data, variant);
+        current_cost += route_costs[i];
+        for(int k = 0; k < routes[i].length; k++) {
+            route_of[routes[i].stops[k]] = i;
+            position_of[routes[i].stops[k]] = k;
+        }
+    }
+
     for(int i = 0; i < n_routes; i++) {
         cvrp_route* route_i = &routes[i];
-        for(int j = 0; j < n_routes; j++) {
+        // one try per stop and one more with a random route, until the route is spliced
+        for(int t = 0; t <= route_i->length && !spliced[i]; t++) {
+            int a, b, j;
+            if(t < route_i->length) {
+                if(data->_n_search_neighbors == 0) continue;
+                a = rand()%(route_i->length);
+                int* neighbors = &data->_search_neighbors[route_i->stops[a]*data->_n_search_neighbors];
+                int next = neighbors[rand()%data->_n_search_neighbors];
+                j = route_of[next];
+                b = position_of[next]-1;
+            } else {
+                // the neighbours are never on an empty route, this try lets stops move onto
+                // an unused vehicle: a or b is -1 when a whole route is handed over
+                j = rand()%n_routes;
+                if(route_i->length == 0 && routes[j].length == 0) continue;
+                a = rand()%(route_i->length+1) - 1;
+                b = rand()%(routes[j].length+1) - 1;
+            }
+            if(i == j || spliced[j]) continue;
             cvrp_route* route_j = &routes[j];
-            if(i == j || (route_i->length == 1 && route_j->length == 1) || spliced[j]) continue;
-
-            int a = rand()%(route_i->length);
-            int b = rand()%(route_j->length);
 
-            splice(route_i, route_j, a, b);
-            float current_cost = cvrp_total_cost(routes, n_routes, nodes, depot);
-            bool feasable = cvrp_feasable(routes, n_routes, nodes, cap);
+            // route i keeps its stops up to a and takes the tail of route j after b, and vice versa
+            cvrp_segment new_i = cvrp_segment_concat(data, prefix[i][a+1], suffix[j][b+1]);
+            cvrp_segment new_j = cvrp_segment_concat(data, prefix[j][b+1], suffix[i][a+1]);
+            // the load above the capacities may not grow, so overloaded routes can still hand over stops
+            int cap_i = cvrp_vehicle_cap(data, i), cap_j = cvrp_vehicle_cap(data, j);
+            int excess = cvrp_excess_load(prefix[i][route_i->length], cap_i) + cvrp_excess_load(prefix[j][route_j->length], cap_j);
+            bool feasable = cvrp_excess_load(new_i, cap_i) + cvrp_excess_load(new_j, cap_j) <= excess;
+            float new_cost_i = segment_cost(new_i, i, data, variant), new_cost_j = segment_cost(new_j, j, data, variant);
+            float cost = current_cost - route_costs[i] - route_costs[j] + new_cost_i + new_cost_j;
 
-            float delta_cost = *best_cost - current_cost;
-            if(current_cost < *best_cost && feasable) {
-                *best_cost = current_cost;
-                spliced[i] = spliced[j] = true;
+            float delta_cost = *best_cost - cost;
+            bool accept = false;
+            if(cost < *best_cost && feasable) {
+                *best_cost = cost;
+                accept = true;
             }
             else if (exp((delta_cost)/temperature) > random_real() && feasable) {
-                spliced[i] = spliced[j] = true;
-            } else {
-                splice(route_i, route_j, a, b);
+                accept = true;
             }
+            if(!accept) continue;
 
+            splice(route_i, route_j, a, b);
+            spliced[i] = spliced[j] = true;
+            current_cost = cost;
+            route_costs[i] = new_cost_i;
+            route_costs[j] = new_cost_j;
+            for(int k = 0; k < 2; k++) {
+                int r = k == 0 ? i : j;
+                prefix[r] = realloc(prefix[r], (routes[r].length+1)*sizeof(cvrp_segment));
+                suffix[r] = realloc(suffix[r], (routes[r].length+1)*sizeof(cvrp_segment));
+                cvrp_route_segments(data, routes[r], prefix[r], suffix[r]);
+                for(int p = 0; p < routes[r].length; p++) {
+                    route_of[routes[r].stops[p]] = r;
+                    position_of[routes[r].stops[p]] = p;
+                }
+            }
         }
     }
 
+    for(int i = 0; i < n_routes; i++) {
+        free(prefix[i]);
+        free(suffix[i]);
+    }
     return routes;
 }
 
-void _cvrp_local_search(grasp* g, void* v_nodes, int n_nodes, int* solution, int* n_solution) {
-    cvrp_node* nodes = (cvrp_node*) v_nodes;
-	cvrp_data* data = (cvrp_data*) g->data;
-
-    cvrp_node depot = data->depot;
+GRASP_INLINE void local_search_impl(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int* n_solution, const bool variant) {
     int n_vehicles = data->n_vehicles;
 
     // apply simulated anealing
     float alpha = data->sa_alpha;
     float temperature = data->sa_temp;
     cvrp_route* best_routes = indices_to_routes(solution, data->_routes_indices, n_vehicles);
-    float best_cost = cvrp_total_cost(best_routes, n_vehicles, nodes, depot);
+    float best_cost = solution_cost(best_routes, n_vehicles, data, variant);
     while(temperature > 1) {
 
         cvrp_route* current_routes;
         int r = rand()%4;
         switch (r) {
         case 0:
-            current_routes = best_2opt_neighbor(best_routes, n_vehicles, data->cap, nodes, data->depot, temperature, &best_cost);
+            current_routes = best_2opt_neighbor(best_routes, n_vehicles, data, temperature, &best_cost, variant);
             break;
         case 1:
-            current_routes = best_swap_neighbor(best_routes, n_vehicles, data->cap, nodes, data->depot, temperature, &best_cost);
+            current_routes = best_swap_neighbor(best_routes, n_vehicles, data, temperature, &best_cost, variant);
             break;
         case 2:
-            current_routes = best_invert_neighbor(best_routes, n_vehicles, data->cap, nodes, data->depot, temperature, &best_cost);
+            current_routes = best_invert_neighbor(best_routes, n_vehicles, data, temperature, &best_cost, variant);
             break;
         default:
-            current_routes = best_intra2opt_neighbor(best_routes, n_vehicles, data->cap, nodes, data->depot, temperature, &best_cost);
+            current_routes = best_intra2opt_neighbor(best_routes, n_vehicles, data, temperature, &best_cost, variant);
             break;
         }
-        float current_cost = cvrp_total_cost(current_routes, n_vehicles, nodes, depot);
+        float current_cost = solution_cost(current_routes, n_vehicles, data, variant);
         
         best_cost = current_cost;
         free_routes(best_routes, n_vehicles);
-        best_routes = best_2opt_neighbor(current_routes, n_vehicles, data->cap, nodes, data->depot, 0, &best_cost);
+        best_routes = best_2opt_neighbor(current_routes, n_vehicles, data, 0, &best_cost, variant);
         free_routes(current_routes, n_vehicles);
 
         temperature *= alpha;
@@ -442,28 +567,64 @@ void _cvrp_local_search(grasp* g, void* v_nodes, int n_nodes, int* solution, int
     routes_to_indices(best_routes, n_vehicles, solution, data->_routes_indices);
 }
 
+GRASP_INLINE void _cvrp_local_search(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int* n_solution) {
+    local_search_impl(g, data, nodes, n_nodes, solution, n_solution, false);
+}
+
+GRASP_INLINE void _cvrp_variant_local_search(grasp* g, cvrp_data* data, cvrp_node* nodes, int n_nodes, int* solution, int* n_solution) {
+    local_search_impl(g, data, nodes, n_nodes, solution, n_solution, true);
+}
+
+GRASP_SPECIALIZE(cvrp_grasp_run, cvrp_node, cvrp_data, _cvrp_costs, _cvrp_candidates, _cvrp_compare, _cvrp_local_search, _cvrp_split, _cvrp_evaluate)
+GRASP_SPECIALIZE(cvrp_variant_grasp_run, cvrp_node, cvrp_data, _cvrp_costs, _cvrp_candidates, _cvrp_variant_compare, _cvrp_variant_local_search, _cvrp_variant_split, _cvrp_variant_evaluate)
+
 cvrp_route* cvrp_solve(cvrp_data* data, int iterations, float alpha) {
 
     int _routes_indices[data->n_vehicles];
     int _best_routes_indices[data->n_vehicles];
     data->_routes_indices = _routes_indices;
     data->_best_routes_indices = _best_routes_indices;
+    int _neighbors[CVRP_CANDIDATES];
+    data->_neighbors = _neighbors;
+    data->grid = cvrp_grid_create(data->nodes, NULL, data->n_nodes, data->n_nodes);
+
+    // nearest neighbours of every node, for the local search
+    data->_n_search_neighbors = data->n_nodes-1 < CVRP_SEARCH_NEIGHBORS ? data->n_nodes-1 : CVRP_SEARCH_NEIGHBORS;
+    data->_search_neighbors = malloc((data->n_nodes*data->_n_search_neighbors + 1)*sizeof(int));
+    for(int i = 0; i < data->n_nodes; i++) {
+        int found[CVRP_SEARCH_NEIGHBORS+1];
+        int n_found = cvrp_grid_knearest(data->grid, data->nodes[i].x, data->nodes[i].y, data->_n_search_neighbors+1, found);
+        int* neighbors = &data->_search_neighbors[i*data->_n_search_neighbors];
+        for(int k = 0, n = 0; k < n_found && n < data->_n_search_neighbors; k++) {
+            if(found[k] != i) neighbors[n++] = found[k];
+        }
+    }
+    // the bound is only needed to stop early
+    data->lower_bound = data->gap_tolerance > 0 ? cvrp_distance_bound(data, CVRP_BOUND_ITERATIONS) : NAN;
 
     grasp g = {
         .iterations = iterations,
         .alpha = alpha,
         .max = true,
-        .compute_costs = _cvrp_costs,
-        .compare_solutions = _cvrp_compare,
-        .update_candidates = _cvrp_candidates,
-        .post_construction = _cvrp_split,
-        .local_search = _cvrp_local_search,
+        .bound = data->lower_bound,
+        .gap_tolerance = data->gap_tolerance,
         .data = data
     };
 
     int solution[data->n_nodes];
     int n_solution = 0;
-    grasp_run(&g, (void*)data->nodes, data->n_nodes, solution, &n_solution);
+    if(data->vehicle_caps || data->windows) {
+        cvrp_variant_grasp_run(&g, data->nodes, data->n_nodes, solution, &n_solution);
+    } else {
+        cvrp_grasp_run(&g, data->nodes, data->n_nodes, solution, &n_solution);
+    }
+    data->iterations_run = g.iterations_run;
+    data->gap = g.gap;
+
+    cvrp_grid_free(data->grid);
+    data->grid = NULL;
+    free(data->_search_neighbors);
+    data->_search_neighbors = NULL;
 
     cvrp_route* routes = indices_to_routes(solution, data->_routes_indices, data->n_vehicles);
     return routes;
@@ -7,22 +7,56 @@ typedef struct cvrp_node{
     int demand;
 } cvrp_node;
 
+// Time window of a node
+// ready, due - the earliest and latest start of the service
+// service - the duration of the service
+typedef struct cvrp_window {
+    float ready, due;
+    float service;
+} cvrp_window;
+
 typedef struct cvrp_route {
     int length;
     int* stops;
 } cvrp_route;
 
+// Number of nearest unvisited nodes considered at each step of the construction
+#define CVRP_CANDIDATES 25
+// Number of nearest neighbours of each node considered by the local search
+#define CVRP_SEARCH_NEIGHBORS 10
+// Subgradient iterations of the lower bound
+#define CVRP_BOUND_ITERATIONS 500
+
 typedef struct cvrp_data {
     int cap;
     int n_vehicles, n_nodes;
     cvrp_node depot;
     cvrp_node* nodes;
+    // optional extensions, NULL for plain CVRP instances
+    int* vehicle_caps;
+    cvrp_window* windows;
+    cvrp_window depot_window;
+    // grid over the nodes, built once per solve
+    struct cvrp_grid* grid;
+    int* _neighbors;
+    int _n_neighbors;
+    int* _search_neighbors;
+    int _n_search_neighbors;
+    // vehicle filled by the construction so far and its load
+    int _vehicle, _load;
     int* _routes_indices;
     int* _best_routes_indices;
     float sa_alpha, sa_temp;
     bool verbose;
+    // stop once the gap to the lower bound is within gap_tolerance (0 disables the bound)
+    // lower_bound is NAN when it was not computed
+    float gap_tolerance;
+    float lower_bound, gap;
+    int iterations_run;
 } cvrp_data;
 
+float cvrp_distance(cvrp_node a, cvrp_node b);
+
 cvrp_route* cvrp_solve(cvrp_data* data, int iterations, float alpha);
 
 float cvrp_total_cost(cvrp_route* routes, int n_routes, cvrp_node* nodes, cvrp_node depot);
\ No newline at end of file
@@ -6,8 +6,29 @@
 #include "grasp.h"
 
 #include "cvrp.h"
+#include "output.h"
 
-void parse_args(int argc, char** argv, FILE** fd, float* alpha, int* iter, float* sa_temp, float* sa_alpha, bool* verbose) {
+#define MAX_REQUEST_ARGS 64
+
+bool parse_format(const char* name, cvrp_output_format* format) {
+    if      (!strcmp(name, "text"))   *format = CVRP_OUTPUT_TEXT;
+    else if (!strcmp(name, "json"))   *format = CVRP_OUTPUT_JSON;
+    else if (!strcmp(name, "binary")) *format = CVRP_OUTPUT_BINARY;
+    else return false;
+    return true;
+}
+
+// Parse the value of a numeric option, the whole value must be a number
+bool parse_number(const char* value, double* number) {
+    char* end;
+    *number = strtod(value, &end);
+    return end != value && *end == '\0';
+}
+
+// Parse the arguments of a solve request: the instance file followed by the options
+// Returns NULL on success or a message describing the error
+const char* parse_args(int argc, char** argv, FILE** fd, float* alpha, int* iter, float* sa_temp, float* sa_alpha, bool* verbose, float* gap, cvrp_output_format* format) {
+    static char message[256];
 
     // Default
     *alpha = 0.5;
@@ -15,69 +36,130 @@ void parse_args(int argc, char** argv, FILE** fd, float* alpha, int* iter, float
     *sa_temp = 3000;
     *sa_alpha = 0.9;
     *verbose = false;
+    *gap = 0;
 
     if (argc < 2) {
-        printf("No input file!\n");
-        exit(1);
+        return "No input file!";
     }
 
-    *fd = fopen(argv[1], "r");
-    if (*fd == NULL) {
-        printf("Invalid file \"%s\"\n", argv[1]);
-        exit(1);
-    }
     for (int i = 2; i < argc; i++) {
         char* arg = argv[i];
+        bool numeric = !strcmp(arg, "--alpha") || !strcmp(arg, "--iter") || !strcmp(arg, "--satemp") ||
+                       !strcmp(arg, "--saalpha") || !strcmp(arg, "--gap");
+        if ((numeric || !strcmp(arg, "--format")) && i+1 >= argc) {
+            snprintf(message, sizeof(message), "Missing value for \"%s\"", arg);
+            return message;
+        }
+        double value;
+        if (numeric && !parse_number(argv[i+1], &value)) {
+            snprintf(message, sizeof(message), "Invalid value for \"%s\": \"%s\"", arg, argv[i+1]);
+            return message;
+        }
 
         if      (!strcmp(arg, "--alpha")) {
-            *alpha = atof(argv[++i]);
+            *alpha = value;
+            i++;
         }
         else if (!strcmp(arg, "--iter")) {
-            *iter = atoi(argv[++i]);
+            *iter = value;
+            i++;
         }
         else if (!strcmp(arg, "--satemp")) {
-            *sa_temp = atof(argv[++i]);
+            *sa_temp = value;
+            i++;
         }
         else if (!strcmp(arg, "--saalpha")) {
-            *sa_alpha = atof(argv[++i]);
+            *sa_alpha = value;
+            i++;
+        }
+        else if (!strcmp(arg, "--gap")) {
+            *gap = value;
+            i++;
+        }
+        else if (!strcmp(arg, "--format")) {
+            if (!parse_format(argv[++i], format)) return "Invalid format, expected text, json or binary";
         }
         else if (!strcmp(arg, "--verbose")) {
             *verbose = true;
         }
     }
-}
-
-int main(int argc, char** argv) {
-    srand(time(NULL));
 
+    *fd = fopen(argv[1], "r");
+    if (*fd == NULL) {
+        snprintf(message, sizeof(message), "Invalid file \"%s\"", argv[1]);
+        return message;
+    }
+    return NULL;
+}
 
-    FILE* fd;
-    float alpha, sa_alpha, sa_temp;
-    int iter;
-    bool verbose;
-    parse_args(argc, argv, &fd, &alpha, &iter, &sa_temp, &sa_alpha, &verbose);
+// Split a "number value..." line of a section and parse its n_values values
+// Returns false if the line has fewer values or one of them is not a number
+bool parse_row(char* line, int n_values, double* values) {
+    char* token = strtok(line, " \t\r\n");
+    if (token == NULL) return false;
+    for (int i = 0; i < n_values; i++) {
+        token = strtok(NULL, " \t\r\n");
+        if (token == NULL) return false;
+        char* end;
+        values[i] = strtod(token, &end);
+        if (end == token) return false;
+    }
+    return true;
+}
 
+// Read an instance in the TSPLIB format, the nodes are allocated with malloc
+// Two optional sections may follow the demands:
+//   VEHICLE_CAPACITY_SECTION - one "vehicle capacity" line per vehicle
+//   TIME_WINDOW_SECTION - one "node ready due service" line per node, the depot included
+// Returns NULL on success or a message describing the error, data is left untouched on error
+const char* read_instance(FILE* fd, cvrp_data* data) {
     int n;
     int k;
+    const char* error = NULL;
+    cvrp_node* nodes = NULL;
+    int* vehicle_caps = NULL;
+    cvrp_window* windows = NULL;
 
     // read file
     char* buff = NULL;
     size_t size = 0;
-    getline(&buff, &size, fd);
-    sscanf(buff, "%*[^0-9]%d%*[^0-9]%d", &n, &k);
-    while(!strstr(buff, "CAPACITY")) getline(&buff, &size, fd);
+    if (getline(&buff, &size, fd) == -1 || sscanf(buff, "%*[^0-9]%d%*[^0-9]%d", &n, &k) != 2) {
+        error = "missing the number of nodes and vehicles in the name";
+        goto fail;
+    }
+    if (n < 2 || k < 1) {
+        error = "expected at least one customer and one vehicle";
+        goto fail;
+    }
+    do {
+        if (getline(&buff, &size, fd) == -1) {
+            error = "missing CAPACITY";
+            goto fail;
+        }
+    } while(!strstr(buff, "CAPACITY"));
 
-    int cap = atoi(buff+11);
+    char* value = strchr(buff, ':');
+    int cap = value ? atoi(value+1) : 0;
+    if (cap <= 0) {
+        error = "invalid CAPACITY";
+        goto fail;
+    }
 
-    getline(&buff, &size, fd);
+    if (getline(&buff, &size, fd) == -1) {
+        error = "missing NODE_COORD_SECTION";
+        goto fail;
+    }
 
     cvrp_node depot;
-    cvrp_node nodes[n-1];
+    nodes = malloc((n-1)*sizeof(cvrp_node));
     for (int i = 0; i < n; i++) {
-        getline(&buff, &size, fd);
-        strtok(buff, " ");
-        int x = atoi(strtok(NULL, " "));
-        int y = atoi(strtok(NULL, " "));
+        double coords[2];
+        if (getline(&buff, &size, fd) == -1 || !parse_row(buff, 2, coords)) {
+            error = "expected one \"node x y\" line per node in NODE_COORD_SECTION";
+            goto fail;
+        }
+        int x = coords[0];
+        int y = coords[1];
         if(i == 0) {
             depot = (cvrp_node){.x = x, .y = y};
         } else {
@@ -85,30 +167,136 @@ int main(int argc, char** argv) {
         }
 
     }
-    getline(&buff, &size, fd);
+    if (getline(&buff, &size, fd) == -1) {
+        error = "missing DEMAND_SECTION";
+        goto fail;
+    }
     for (int i = 0; i < n; i++) {
-        getline(&buff, &size, fd);
-        strtok(buff, " ");
-        int demand = atoi(strtok(NULL, " "));
+        double demand;
+        if (getline(&buff, &size, fd) == -1 || !parse_row(buff, 1, &demand)) {
+            error = "expected one \"node demand\" line per node in DEMAND_SECTION";
+            goto fail;
+        }
         if(i == 0) {
             depot.demand = demand;
         } else {
             nodes[i-1].demand = demand;
         }
     }
-    fclose(fd);
+
+    // the rows of the optional sections are numbered from 1, with exactly k capacities and n windows
+    static char message[256];
+    cvrp_window depot_window;
+    int extra_row = 0;
+    const char* section = NULL;
+    while (getline(&buff, &size, fd) != -1) {
+        if (extra_row && atoi(buff) == extra_row) {
+            snprintf(message, sizeof(message), "%s has more than %d rows", section, extra_row-1);
+            error = message;
+            goto fail;
+        }
+        extra_row = 0;
+
+        if (strstr(buff, "VEHICLE_CAPACITY_SECTION")) {
+            section = "VEHICLE_CAPACITY_SECTION";
+            if (vehicle_caps) {
+                error = "duplicate VEHICLE_CAPACITY_SECTION";
+                goto fail;
+            }
+            vehicle_caps = malloc(k*sizeof(int));
+            for (int i = 0; i < k; i++) {
+                double vehicle_cap;
+                if (getline(&buff, &size, fd) == -1 || atoi(buff) != i+1 || !parse_row(buff, 1, &vehicle_cap) || vehicle_cap <= 0) {
+                    snprintf(message, sizeof(message), "expected %d \"vehicle capacity\" rows in %s, numbered from 1, with positive capacities", k, section);
+                    error = message;
+                    goto fail;
+                }
+                vehicle_caps[i] = vehicle_cap;
+            }
+            extra_row = k+1;
+        }
+        else if (strstr(buff, "TIME_WINDOW_SECTION")) {
+            section = "TIME_WINDOW_SECTION";
+            if (windows) {
+                error = "duplicate TIME_WINDOW_SECTION";
+                goto fail;
+            }
+            windows = malloc((n-1)*sizeof(cvrp_window));
+            for (int i = 0; i < n; i++) {
+                double values[3];
+                if (getline(&buff, &size, fd) == -1 || atoi(buff) != i+1 || !parse_row(buff, 3, values) ||
+                    values[0] > values[1] || values[2] < 0) {
+                    snprintf(message, sizeof(message), "expected %d \"node ready due service\" rows in %s, numbered from 1, with ready <= due", n, section);
+                    error = message;
+                    goto fail;
+                }
+                cvrp_window window = {.ready = values[0], .due = values[1], .service = values[2]};
+                if(i == 0) {
+                    depot_window = window;
+                } else {
+                    windows[i-1] = window;
+                }
+            }
+            extra_row = n+1;
+        }
+    }
+    free(buff);
+
+    data->cap = cap;
+    data->depot = depot;
+    data->nodes = nodes;
+    data->n_nodes = n-1;
+    data->n_vehicles = k;
+    data->vehicle_caps = vehicle_caps;
+    data->windows = windows;
+    if (windows) data->depot_window = depot_window;
+    return NULL;
+
+fail:
     free(buff);
+    free(nodes);
+    free(vehicle_caps);
+    free(windows);
+    return error;
+}
+
+// Solve a single request and write the response to stdout
+// Returns false if the request was invalid
+bool solve_request(int argc, char** argv, cvrp_output_format format, bool serving) {
+    FILE* fd;
+    float alpha, sa_alpha, sa_temp, gap;
+    int iter;
+    bool verbose;
+    cvrp_output_format serve_format = format;
+    const char* error = parse_args(argc, argv, &fd, &alpha, &iter, &sa_temp, &sa_alpha, &verbose, &gap, &format);
+    // text responses have no delimiter, the client could not tell where they end
+    if (serving && format == CVRP_OUTPUT_TEXT) {
+        format = serve_format;
+        if (!error) {
+            fclose(fd);
+            error = "The text format cannot be served, expected json or binary";
+        }
+    }
+    if (error) {
+        cvrp_write_error(stdout, format, error);
+        return false;
+    }
 
     cvrp_data data = {
-        .cap = cap,
-        .depot = depot,
-        .nodes = nodes,
-        .n_nodes = n-1,
-        .n_vehicles = k,
         .sa_alpha = sa_alpha,
         .sa_temp = sa_temp,
-        .verbose = verbose
+        // progress lines would be mixed with the responses
+        .verbose = verbose && !serving,
+        .gap_tolerance = gap
     };
+    error = read_instance(fd, &data);
+    fclose(fd);
+    if (error) {
+        static char message[512];
+        snprintf(message, sizeof(message), "Invalid instance \"%s\": %s", argv[1], error);
+        cvrp_write_error(stdout, format, message);
+        return false;
+    }
 
     clock_t start, end;
     double elapsed_time;
@@ -117,21 +305,47 @@ int main(int argc, char** argv) {
     end = clock();
     elapsed_time = (double)(end-start)/CLOCKS_PER_SEC;
 
-    if(!verbose) {
-        for(int i = 0; i < data.n_vehicles; i++) {
-            printf("Route #%d: ", i+1);
-            
-            cvrp_route route = routes[i];
-            for(int j = 0; j < route.length; j++) {
-                printf("%d ", route.stops[j]+1);
-            }
-            printf("\n");
+    cvrp_write_solution(stdout, format, &data, routes, elapsed_time);
+
+    for(int i = 0; i < data.n_vehicles; i++) free(routes[i].stops);
+    free(routes);
+    free(data.nodes);
+    free(data.vehicle_caps);
+    free(data.windows);
+    return true;
+}
+
+// Answer solve requests read from stdin, one per line, until end of input
+// Each line holds the same arguments as the command line: the instance file followed by the options
+// Every response is a JSON line or a binary frame, so format cannot be text
+void serve(cvrp_output_format format) {
+    char* line = NULL;
+    size_t size = 0;
+    while (getline(&line, &size, stdin) != -1) {
+        char* argv[MAX_REQUEST_ARGS];
+        int argc = 0;
+        argv[argc++] = "serve";
+        for (char* token = strtok(line, " \t\r\n"); token && argc < MAX_REQUEST_ARGS; token = strtok(NULL, " \t\r\n")) {
+            argv[argc++] = token;
         }
+        if (argc == 1) continue;
+        solve_request(argc, argv, format, true);
     }
+    free(line);
+}
 
-    printf("Cost %.0f\n", cvrp_total_cost(routes, data.n_vehicles, nodes, depot));
-    printf("Time %.5f seconds\n", elapsed_time);
+int main(int argc, char** argv) {
+    srand(time(NULL));
 
-    for(int i = 0; i < data.n_vehicles; i++) free(routes[i].stops);
-    free(routes);
-}
\ No newline at end of file
+    if (argc >= 2 && !strcmp(argv[1], "--serve")) {
+        cvrp_output_format format = CVRP_OUTPUT_JSON;
+        if (argc >= 4 && !strcmp(argv[2], "--format") && (!parse_format(argv[3], &format) || format == CVRP_OUTPUT_TEXT)) {
+            printf("Invalid format \"%s\", --serve answers in json or binary\n", argv[3]);
+            exit(1);
+        }
+        serve(format);
+        return 0;
+    }
+
+    if (!solve_request(argc, argv, CVRP_OUTPUT_TEXT, false)) exit(1);
+}
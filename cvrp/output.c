@@ -0,0 +1,164 @@
+#include "output.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "segment.h"
+
+static int route_load(cvrp_route route, cvrp_node* nodes) {
+    int load = 0;
+    for(int i = 0; i < route.length; i++) load += nodes[route.stops[i]].demand;
+    return load;
+}
+
+static float route_cost(cvrp_route route, cvrp_node* nodes, cvrp_node depot) {
+    if(route.length == 0) return 0;
+    return cvrp_total_cost(&route, 1, nodes, depot);
+}
+
+static float route_time_warp(cvrp_data* data, cvrp_route route) {
+    if(!data->windows) return 0;
+    return cvrp_route_segment(data, route).time_warp;
+}
+
+static bool solution_feasible(cvrp_data* data, cvrp_route* routes) {
+    return cvrp_solution_feasible(routes, data->n_vehicles, data);
+}
+
+static float solution_time_warp(cvrp_data* data, cvrp_route* routes) {
+    float time_warp = 0;
+    for(int i = 0; i < data->n_vehicles; i++) time_warp += route_time_warp(data, routes[i]);
+    return time_warp;
+}
+
+// The cost minimized by the search on the variants, the gap is relative to it
+// It is the distance plus the time warp and load penalties, so just the distance of a feasible plain solution
+static float solution_objective(cvrp_data* data, cvrp_route* routes) {
+    return cvrp_variant_cost(routes, data->n_vehicles, data);
+}
+
+static void write_text(FILE* out, cvrp_data* data, cvrp_route* routes, double time) {
+    if(!data->verbose) {
+        for(int i = 0; i < data->n_vehicles; i++) {
+            fprintf(out, "Route #%d: ", i+1);
+
+            cvrp_route route = routes[i];
+            for(int j = 0; j < route.length; j++) {
+                fprintf(out, "%d ", route.stops[j]+1);
+            }
+            if(data->windows) fprintf(out, "(time warp %.2f)", route_time_warp(data, route));
+            fprintf(out, "\n");
+        }
+    }
+
+    fprintf(out, "Cost %.0f\n", cvrp_total_cost(routes, data->n_vehicles, data->nodes, data->depot));
+    // the plain output is kept as is, the variants also report what the cost leaves out
+    if(data->vehicle_caps || data->windows) {
+        fprintf(out, "Time warp %.2f\n", solution_time_warp(data, routes));
+        fprintf(out, "Objective %.0f\n", solution_objective(data, routes));
+        fprintf(out, "Feasible %s\n", solution_feasible(data, routes) ? "yes" : "no");
+    }
+    fprintf(out, "Time %.5f seconds\n", time);
+    // only reported when the run could stop early
+    if(!isnan(data->lower_bound)) {
+        fprintf(out, "Bound %.0f\n", data->lower_bound);
+        fprintf(out, "Gap %.4f\n", data->gap);
+        fprintf(out, "Iterations %d\n", data->iterations_run);
+    }
+}
+
+static void write_json(FILE* out, cvrp_data* data, cvrp_route* routes, double time) {
+    fprintf(out, "{\"cost\":%.2f,\"objective\":%.2f,\"time_warp\":%.2f,\"feasible\":%s,\"time\":%.5f,\"iterations\":%d,",
+            cvrp_total_cost(routes, data->n_vehicles, data->nodes, data->depot), solution_objective(data, routes),
+            solution_time_warp(data, routes), solution_feasible(data, routes) ? "true" : "false", time, data->iterations_run);
+    // the bound is NAN when it was not computed and the gap may be infinite, JSON has neither
+    if(isfinite(data->lower_bound)) fprintf(out, "\"bound\":%.2f,", data->lower_bound);
+    else fprintf(out, "\"bound\":null,");
+    if(isfinite(data->gap)) fprintf(out, "\"gap\":%.4f,\"routes\":[", data->gap);
+    else fprintf(out, "\"gap\":null,\"routes\":[");
+    for(int i = 0; i < data->n_vehicles; i++) {
+        cvrp_route route = routes[i];
+        fprintf(out, "%s{\"load\":%d,\"cost\":%.2f,\"time_warp\":%.2f,\"stops\":[", i == 0 ? "" : ",",
+                route_load(route, data->nodes), route_cost(route, data->nodes, data->depot), route_time_warp(data, route));
+        for(int j = 0; j < route.length; j++) fprintf(out, "%s%d", j == 0 ? "" : ",", route.stops[j]+1);
+        fprintf(out, "]}");
+    }
+    fprintf(out, "]}\n");
+}
+
+static void write_binary_header(FILE* out, uint32_t size, int32_t status) {
+    int32_t version = CVRP_BINARY_VERSION;
+    fwrite(&size, sizeof(size), 1, out);
+    fwrite("CVRP", 1, 4, out);
+    fwrite(&version, sizeof(version), 1, out);
+    fwrite(&status, sizeof(status), 1, out);
+}
+
+static void write_binary(FILE* out, cvrp_data* data, cvrp_route* routes, double time) {
+    int32_t counts[3] = {data->n_vehicles, data->iterations_run, solution_feasible(data, routes)};
+    float values[5] = {
+        cvrp_total_cost(routes, data->n_vehicles, data->nodes, data->depot), solution_objective(data, routes),
+        solution_time_warp(data, routes), data->lower_bound, data->gap
+    };
+
+    uint32_t size = 4 + 2*sizeof(int32_t) + sizeof(counts) + sizeof(values) + sizeof(time);
+    for(int i = 0; i < data->n_vehicles; i++) size += 2*sizeof(int32_t) + 2*sizeof(float) + routes[i].length*sizeof(int32_t);
+
+    write_binary_header(out, size, 0);
+    fwrite(counts, sizeof(int32_t), 3, out);
+    fwrite(values, sizeof(float), 5, out);
+    fwrite(&time, sizeof(time), 1, out);
+
+    for(int i = 0; i < data->n_vehicles; i++) {
+        cvrp_route route = routes[i];
+        int32_t header[2] = {route.length, route_load(route, data->nodes)};
+        float route_values[2] = {route_cost(route, data->nodes, data->depot), route_time_warp(data, route)};
+        fwrite(header, sizeof(int32_t), 2, out);
+        fwrite(route_values, sizeof(float), 2, out);
+        for(int j = 0; j < route.length; j++) {
+            int32_t stop = route.stops[j]+1;
+            fwrite(&stop, sizeof(stop), 1, out);
+        }
+    }
+}
+
+void cvrp_write_solution(FILE* out, cvrp_output_format format, cvrp_data* data, cvrp_route* routes, double time) {
+    switch (format) {
+    case CVRP_OUTPUT_JSON:
+        write_json(out, data, routes, time);
+        break;
+    case CVRP_OUTPUT_BINARY:
+        write_binary(out, data, routes, time);
+        break;
+    default:
+        write_text(out, data, routes, time);
+        break;
+    }
+    fflush(out);
+}
+
+void cvrp_write_error(FILE* out, cvrp_output_format format, const char* message) {
+    switch (format) {
+    case CVRP_OUTPUT_JSON:
+        fprintf(out, "{\"error\":\"");
+        for(const char* c = message; *c; c++) {
+            if(*c == '"' || *c == '\\') fputc('\\', out);
+            fputc(*c, out);
+        }
+        fprintf(out, "\"}\n");
+        break;
+    case CVRP_OUTPUT_BINARY: {
+        int32_t length = strlen(message);
+        write_binary_header(out, 4 + 3*sizeof(int32_t) + length, 1);
+        fwrite(&length, sizeof(length), 1, out);
+        fwrite(message, 1, length, out);
+        break;
+    }
+    default:
+        fprintf(out, "%s\n", message);
+        break;
+    }
+    fflush(out);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "cvrp.h"
+
+typedef enum { CVRP_OUTPUT_TEXT, CVRP_OUTPUT_JSON, CVRP_OUTPUT_BINARY } cvrp_output_format;
+
+// Binary format, all fields in native byte order:
+//   uint32 size       - the number of bytes that follow
+//   char   magic[4]   - "CVRP"
+//   int32  version    - CVRP_BINARY_VERSION
+//   int32  status     - 0 on success, 1 on error
+//   on error only:
+//   int32  length     - the length of the message
+//   char   message[length] - the error message, not NUL terminated
+//   on success:
+//   int32  n_routes, iterations
+//   int32  feasible   - 1 if every route fits its vehicle and has no time warp
+//   float  cost       - the total distance
+//   float  objective  - the distance plus the time warp and excess load penalties, the gap is relative to it
+//   float  time_warp  - the total time warp
+//   float  bound, gap - bound is NAN and gap infinite when no gap tolerance was given
+//   double time       - seconds
+//   then for each route:
+//   int32  length, load
+//   float  cost, time_warp
+//   int32  stops[length] - customer numbers as in the .sol files and the text output
+#define CVRP_BINARY_VERSION 3
+
+// Write the solution of the instance in data
+// routes - the routes returned by cvrp_solve
+// time - the solving time in seconds
+void cvrp_write_solution(FILE* out, cvrp_output_format format, cvrp_data* data, cvrp_route* routes, double time);
+
+// Write an error response, in the given format
+void cvrp_write_error(FILE* out, cvrp_output_format format, const char* message);
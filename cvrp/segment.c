@@ -0,0 +1,35 @@
+#include "segment.h"
+
+void cvrp_route_segments(cvrp_data* data, cvrp_route route, cvrp_segment* prefix, cvrp_segment* suffix) {
+    prefix[0] = cvrp_segment_node(data, CVRP_DEPOT);
+    for(int k = 0; k < route.length; k++) {
+        prefix[k+1] = cvrp_segment_concat(data, prefix[k], cvrp_segment_node(data, route.stops[k]));
+    }
+
+    suffix[route.length] = cvrp_segment_node(data, CVRP_DEPOT);
+    for(int k = route.length-1; k >= 0; k--) {
+        suffix[k] = cvrp_segment_concat(data, cvrp_segment_node(data, route.stops[k]), suffix[k+1]);
+    }
+}
+
+cvrp_segment cvrp_route_segment(cvrp_data* data, cvrp_route route) {
+    cvrp_segment segment = cvrp_segment_node(data, CVRP_DEPOT);
+    for(int k = 0; k < route.length; k++) {
+        segment = cvrp_segment_concat(data, segment, cvrp_segment_node(data, route.stops[k]));
+    }
+    return cvrp_segment_concat(data, segment, cvrp_segment_node(data, CVRP_DEPOT));
+}
+
+float cvrp_variant_cost(cvrp_route* routes, int n_routes, cvrp_data* data) {
+    float total_cost = 0;
+    for(int i = 0; i < n_routes; i++) total_cost += cvrp_segment_cost(cvrp_route_segment(data, routes[i]), cvrp_vehicle_cap(data, i));
+    return total_cost;
+}
+
+bool cvrp_solution_feasible(cvrp_route* routes, int n_routes, cvrp_data* data) {
+    for(int i = 0; i < n_routes; i++) {
+        cvrp_segment segment = cvrp_route_segment(data, routes[i]);
+        if(segment.load > cvrp_vehicle_cap(data, i) || segment.time_warp > 0) return false;
+    }
+    return true;
+}
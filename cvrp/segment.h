@@ -0,0 +1,93 @@
+#pragma once
+
+#include <math.h>
+
+#include "cvrp.h"
+
+// Weight of one unit of time warp in the cost of a solution with time windows
+#define CVRP_TIME_WARP_PENALTY 100
+// Weight of one unit of load above the capacity of the vehicle in the cost of a solution
+#define CVRP_LOAD_PENALTY 100
+
+// Summary of a sequence of consecutive stops, used to evaluate routes of the
+// heterogeneous fleet / time window variant. Two segments are concatenated in O(1),
+// so any route made of pieces of other routes can be evaluated from the prefix and
+// suffix segments of those routes without walking their stops.
+// first, last - the first and last node of the segment (CVRP_DEPOT for the depot)
+// duration - the minimum duration to serve the segment, including waiting
+// time_warp - how much the windows of the segment are violated
+// earliest, latest - the window for the start of the service at the first node
+// load - the total demand of the segment
+// distance - the length of the segment
+typedef struct cvrp_segment {
+    int first, last;
+    float duration, time_warp;
+    float earliest, latest;
+    int load;
+    float distance;
+} cvrp_segment;
+
+#define CVRP_DEPOT -1
+
+static inline cvrp_node cvrp_node_at(cvrp_data* data, int node) {
+    return node == CVRP_DEPOT ? data->depot : data->nodes[node];
+}
+
+// The segment that visits a single node
+static inline cvrp_segment cvrp_segment_node(cvrp_data* data, int node) {
+    cvrp_window window = {.ready = 0, .due = INFINITY, .service = 0};
+    if(data->windows) window = node == CVRP_DEPOT ? data->depot_window : data->windows[node];
+    return (cvrp_segment){
+        .first = node, .last = node,
+        .duration = window.service, .time_warp = 0,
+        .earliest = window.ready, .latest = window.due,
+        .load = node == CVRP_DEPOT ? 0 : data->nodes[node].demand,
+        .distance = 0
+    };
+}
+
+// The segment that visits a and then b, travel times are the distances between the nodes
+static inline cvrp_segment cvrp_segment_concat(cvrp_data* data, cvrp_segment a, cvrp_segment b) {
+    float travel = cvrp_distance(cvrp_node_at(data, a.last), cvrp_node_at(data, b.first));
+    float delta = a.duration - a.time_warp + travel;
+    float wait = fmaxf(b.earliest - delta - a.latest, 0);
+    float warp = fmaxf(a.earliest + delta - b.latest, 0);
+    return (cvrp_segment){
+        .first = a.first, .last = b.last,
+        .duration = a.duration + b.duration + travel + wait,
+        .time_warp = a.time_warp + b.time_warp + warp,
+        .earliest = fmaxf(b.earliest - delta, a.earliest) - wait,
+        .latest = fminf(b.latest - delta, a.latest) + warp,
+        .load = a.load + b.load,
+        .distance = a.distance + b.distance + travel
+    };
+}
+
+// Load of the segment above the capacity cap
+static inline int cvrp_excess_load(cvrp_segment segment, int cap) {
+    return segment.load > cap ? segment.load - cap : 0;
+}
+
+// The cost of a route served by a vehicle with capacity cap
+static inline float cvrp_segment_cost(cvrp_segment segment, int cap) {
+    return segment.distance + CVRP_TIME_WARP_PENALTY*segment.time_warp + CVRP_LOAD_PENALTY*cvrp_excess_load(segment, cap);
+}
+
+// Capacity of the vehicle that serves the route with the given index
+static inline int cvrp_vehicle_cap(cvrp_data* data, int vehicle) {
+    return data->vehicle_caps ? data->vehicle_caps[vehicle] : data->cap;
+}
+
+// Compute the prefix and suffix segments of a route, both with room for length+1 items
+// prefix[k] - the depot followed by the first k stops
+// suffix[k] - the stops from k onwards followed by the depot
+void cvrp_route_segments(cvrp_data* data, cvrp_route route, cvrp_segment* prefix, cvrp_segment* suffix);
+
+// The segment of a whole route, from the depot back to the depot
+cvrp_segment cvrp_route_segment(cvrp_data* data, cvrp_route route);
+
+// Total distance plus the time warp and load penalties of the routes, route i served by vehicle i
+float cvrp_variant_cost(cvrp_route* routes, int n_routes, cvrp_data* data);
+
+// Every route fits its vehicle and meets its time windows
+bool cvrp_solution_feasible(cvrp_route* routes, int n_routes, cvrp_data* data);
@@ -0,0 +1,186 @@
+#include "spatial.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+static int grid_col(cvrp_grid* grid, int x) {
+    if(x < grid->min_x) return 0;
+    int col = (x - grid->min_x)/grid->cell_size;
+    return col < grid->n_cols ? col : grid->n_cols-1;
+}
+
+static int grid_row(cvrp_grid* grid, int y) {
+    if(y < grid->min_y) return 0;
+    int row = (y - grid->min_y)/grid->cell_size;
+    return row < grid->n_rows ? row : grid->n_rows-1;
+}
+
+static long squared_distance(cvrp_node node, int x, int y) {
+    long dx = node.x - x;
+    long dy = node.y - y;
+    return dx*dx + dy*dy;
+}
+
+cvrp_grid* cvrp_grid_create(cvrp_node* nodes, int* indices, int n_indices, int n_nodes) {
+    cvrp_grid* grid = malloc(sizeof(cvrp_grid));
+    grid->nodes = nodes;
+    grid->n_positions = n_nodes;
+    grid->n_alive = n_indices;
+
+    int min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+    for(int i = 0; i < n_indices; i++) {
+        cvrp_node node = nodes[indices ? indices[i] : i];
+        if(i == 0 || node.x < min_x) min_x = node.x;
+        if(i == 0 || node.y < min_y) min_y = node.y;
+        if(i == 0 || node.x > max_x) max_x = node.x;
+        if(i == 0 || node.y > max_y) max_y = node.y;
+    }
+    grid->min_x = min_x;
+    grid->min_y = min_y;
+
+    // aim for about two points per cell
+    long width = max_x - min_x + 1;
+    long height = max_y - min_y + 1;
+    int cell_size = n_indices > 0 ? (int)ceil(sqrt(2.0*width*height/n_indices)) : 1;
+    grid->cell_size = cell_size > 0 ? cell_size : 1;
+    grid->n_cols = (width + grid->cell_size - 1)/grid->cell_size;
+    grid->n_rows = (height + grid->cell_size - 1)/grid->cell_size;
+
+    int n_cells = grid->n_cols*grid->n_rows;
+    grid->cell_start = malloc((n_cells+1)*sizeof(int));
+    grid->cell_count = calloc(n_cells, sizeof(int));
+    grid->cell_items = malloc((n_indices > 0 ? n_indices : 1)*sizeof(int));
+    grid->position = malloc((n_nodes > 0 ? n_nodes : 1)*sizeof(int));
+    for(int i = 0; i < n_nodes; i++) grid->position[i] = -1;
+
+    // bucket the points by cell
+    for(int i = 0; i < n_indices; i++) {
+        cvrp_node node = nodes[indices ? indices[i] : i];
+        grid->cell_count[grid_row(grid, node.y)*grid->n_cols + grid_col(grid, node.x)]++;
+    }
+    grid->cell_start[0] = 0;
+    for(int c = 0; c < n_cells; c++) {
+        grid->cell_start[c+1] = grid->cell_start[c] + grid->cell_count[c];
+        grid->cell_count[c] = 0;
+    }
+    for(int i = 0; i < n_indices; i++) {
+        int index = indices ? indices[i] : i;
+        cvrp_node node = nodes[index];
+        int c = grid_row(grid, node.y)*grid->n_cols + grid_col(grid, node.x);
+        int position = grid->cell_start[c] + grid->cell_count[c]++;
+        grid->cell_items[position] = index;
+        grid->position[index] = position;
+    }
+
+    return grid;
+}
+
+void cvrp_grid_free(cvrp_grid* grid) {
+    free(grid->cell_start);
+    free(grid->cell_count);
+    free(grid->cell_items);
+    free(grid->position);
+    free(grid);
+}
+
+void cvrp_grid_reset(cvrp_grid* grid) {
+    // removed points are kept at the end of their cell, so every cell just becomes full again
+    int n_cells = grid->n_cols*grid->n_rows;
+    grid->n_alive = grid->cell_start[n_cells];
+    for(int c = 0; c < n_cells; c++) {
+        grid->cell_count[c] = grid->cell_start[c+1] - grid->cell_start[c];
+        for(int p = grid->cell_start[c]; p < grid->cell_start[c+1]; p++) grid->position[grid->cell_items[p]] = p;
+    }
+}
+
+void cvrp_grid_remove(cvrp_grid* grid, int index) {
+    int position = grid->position[index];
+    if(position < 0) return;
+
+    cvrp_node node = grid->nodes[index];
+    int c = grid_row(grid, node.y)*grid->n_cols + grid_col(grid, node.x);
+
+    // move the last alive point of the cell into the freed slot
+    int last = grid->cell_start[c] + --grid->cell_count[c];
+    int moved = grid->cell_items[last];
+    grid->cell_items[position] = moved;
+    grid->position[moved] = position;
+    grid->cell_items[last] = index;
+    grid->position[index] = -1;
+    grid->n_alive--;
+}
+
+int cvrp_grid_nearest(cvrp_grid* grid, int x, int y) {
+    int nearest;
+    if(cvrp_grid_knearest(grid, x, y, 1, &nearest) == 0) return -1;
+    return nearest;
+}
+
+int cvrp_grid_knearest(cvrp_grid* grid, int x, int y, int k, int* out) {
+    if(k <= 0 || grid->n_alive == 0) return 0;
+
+    long distances[k];
+    int n_found = 0;
+    int n_seen = 0;
+
+    int cx = grid_col(grid, x);
+    int cy = grid_row(grid, y);
+    int max_ring = grid->n_cols > grid->n_rows ? grid->n_cols : grid->n_rows;
+
+    // visit the cells ring by ring around the query point
+    for(int r = 0; r <= max_ring && n_seen < grid->n_alive; r++) {
+        for(int row = cy-r; row <= cy+r; row++) {
+            if(row < 0 || row >= grid->n_rows) continue;
+            bool edge = row == cy-r || row == cy+r;
+            int step = edge || r == 0 ? 1 : 2*r;
+            for(int col = cx-r; col <= cx+r; col += step) {
+                if(col < 0 || col >= grid->n_cols) continue;
+                int c = row*grid->n_cols + col;
+                int start = grid->cell_start[c];
+                for(int p = start; p < start + grid->cell_count[c]; p++) {
+                    int index = grid->cell_items[p];
+                    long distance = squared_distance(grid->nodes[index], x, y);
+                    n_seen++;
+                    if(n_found == k && distance >= distances[k-1]) continue;
+
+                    // insert keeping the list sorted by distance
+                    int j = n_found < k ? n_found++ : k-1;
+                    for(; j > 0 && distances[j-1] > distance; j--) {
+                        distances[j] = distances[j-1];
+                        out[j] = out[j-1];
+                    }
+                    distances[j] = distance;
+                    out[j] = index;
+                }
+            }
+        }
+        // no point in the next ring can be closer than r cells away
+        long reach = (long)r*grid->cell_size;
+        if(n_found == k && distances[k-1] <= reach*reach) break;
+    }
+
+    return n_found;
+}
+
+int cvrp_grid_radius(cvrp_grid* grid, int x, int y, float radius, int* out) {
+    if(radius < 0 || grid->n_alive == 0) return 0;
+
+    int r = (int)ceil(radius);
+    int col_start = grid_col(grid, x - r), col_end = grid_col(grid, x + r);
+    int row_start = grid_row(grid, y - r), row_end = grid_row(grid, y + r);
+    double max_distance = (double)radius*radius;
+
+    int n_found = 0;
+    for(int row = row_start; row <= row_end; row++) {
+        for(int col = col_start; col <= col_end; col++) {
+            int c = row*grid->n_cols + col;
+            int start = grid->cell_start[c];
+            for(int p = start; p < start + grid->cell_count[c]; p++) {
+                int index = grid->cell_items[p];
+                if(squared_distance(grid->nodes[index], x, y) <= max_distance) out[n_found++] = index;
+            }
+        }
+    }
+
+    return n_found;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "cvrp.h"
+
+// Uniform grid over the integer coordinates of a set of nodes.
+// Points are bucketed by cell so that nearest, k-nearest and radius queries
+// only look at the cells around the query point instead of every node.
+// Points can be removed after the grid is built (e.g. once a node is visited),
+// which keeps repeated nearest-neighbour queries cheap.
+// cell_size - the width and height of every cell
+// n_cols, n_rows - the dimensions of the grid
+// cell_start - offset of the first point of each cell in cell_items
+// cell_count - the number of points still alive in each cell
+// cell_items - the node indices, grouped by cell
+// position - the position of each node index inside cell_items (-1 if absent)
+typedef struct cvrp_grid {
+    cvrp_node* nodes;
+    int min_x, min_y;
+    int cell_size;
+    int n_cols, n_rows;
+    int* cell_start;
+    int* cell_count;
+    int* cell_items;
+    int* position;
+    int n_positions;
+    int n_alive;
+} cvrp_grid;
+
+// Build a grid over a subset of the nodes
+// nodes - the nodes of the instance
+// indices - the indices of the nodes to be inserted (NULL inserts nodes 0..n_indices-1)
+// n_indices - the number of nodes to be inserted
+// n_nodes - the total number of nodes
+cvrp_grid* cvrp_grid_create(cvrp_node* nodes, int* indices, int n_indices, int n_nodes);
+
+void cvrp_grid_free(cvrp_grid* grid);
+
+// Put back every node removed since the grid was built
+void cvrp_grid_reset(cvrp_grid* grid);
+
+// Remove the node index from the grid, it will not be returned by further queries
+void cvrp_grid_remove(cvrp_grid* grid, int index);
+
+// Return the index of the nearest node to (x, y), or -1 if the grid is empty
+int cvrp_grid_nearest(cvrp_grid* grid, int x, int y);
+
+// Store in out the indices of the k nearest nodes to (x, y), closest first
+// Returns the number of indices found (less than k if the grid has fewer nodes)
+int cvrp_grid_knearest(cvrp_grid* grid, int x, int y, int k, int* out);
+
+// Store in out the indices of every node within distance radius of (x, y)
+// out must have room for every node in the grid
+// Returns the number of indices found
+int cvrp_grid_radius(cvrp_grid* grid, int x, int y, float radius, int* out);
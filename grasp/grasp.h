@@ -9,6 +9,7 @@ typedef void (*grasp_candidates) (grasp* g, void* elements, int n_elements, int*
 typedef void (*grasp_compare) (grasp* g, void* elements, int* solution, int n_solution, int* best_solution, int* n_best_solution, bool first_solution);
 typedef void (*grasp_search) (grasp* g, void* elements, int n_elements, int* solution, int* n_solution);
 typedef void (*grasp_post_construction) (grasp* g, void* elements, int n_elements, int* solution, int n_solution);
+typedef float (*grasp_evaluate) (grasp* g, void* elements, int* best_solution, int n_best_solution);
 
 // This is the struct for and instance of GRASP
 // iterarions - number of iterations
@@ -19,6 +20,15 @@ typedef void (*grasp_post_construction) (grasp* g, void* elements, int n_element
 // update_candidates - function to update the candidate list at each iteration of construction
 // compare_solutions - the function to compare two solutions 
 // local_search - the function that performs local search in the solution space around a specific solution
+// evaluate_best - the function that returns the objective value of the best solution (optional, NULL disables early termination)
+// bound - a bound on the objective value (lower bound if minimizing it, upper bound if maximizing it)
+// gap_tolerance - the run stops once the relative gap between the best solution and the bound is within this value (0 disables it)
+// iterations_run - set by grasp_run to the number of iterations performed
+// gap - set by grasp_run to the final relative gap |best - bound| / |best|, 0 if both are 0 and INFINITY
+//       if only best is (only computed if evaluate_best is set and gap_tolerance > 0)
+// candidate_indices, n_candidate_indices - optionally set by update_candidates to the indices of every
+//       candidate left, so that a construction step only scans them instead of all the elements
+//       (reset to NULL at the start of each construction)
 struct grasp {
 	int iterations;
 	float alpha;
@@ -29,6 +39,13 @@ struct grasp {
 	grasp_compare compare_solutions;
 	grasp_search local_search;
 	grasp_post_construction post_construction;
+	grasp_evaluate evaluate_best;
+	float bound;
+	float gap_tolerance;
+	int iterations_run;
+	float gap;
+	int* candidate_indices;
+	int n_candidate_indices;
 };
 
 // Run the grasp algorithm for a set of elements
@@ -37,4 +54,6 @@ struct grasp {
 // n_elements - the number of elements
 // best_solution - an array of integers where the indices of the items in the best solution will be stored
 // n_best_solution - the number of items selected in the best solution
+// The callbacks are called through the function pointers of g; use GRASP_SPECIALIZE
+// from grasp_inline.h to bind them at compile time instead
 void grasp_run(grasp* g, void* elements, const int n_elements, int* best_solution, int* n_best_solution);
@@ -0,0 +1,156 @@
+#pragma once
+#include <stdlib.h>
+#include <math.h>
+#include "grasp.h"
+
+// Header-only implementation of the GRASP engine.
+// The callbacks are taken as arguments of always-inlined functions, so when they
+// are compile-time constants (see GRASP_SPECIALIZE) the compiler calls them directly
+// and can inline them into construct. grasp_run is the same engine instantiated with
+// the function pointers stored in the grasp struct.
+
+#define GRASP_INLINE static inline __attribute__((always_inline))
+
+// The candidates scanned at each construction step: the candidate_indices set by
+// update_candidates if any, every element otherwise
+#define GRASP_FOR_CANDIDATES(g, k, n_elements, body) \
+	if ((g)->candidate_indices) { \
+		for (int _i = 0; _i < (g)->n_candidate_indices; _i++) { int k = (g)->candidate_indices[_i]; body } \
+	} else { \
+		for (int k = 0; k < (n_elements); k++) { body } \
+	}
+
+GRASP_INLINE float grasp_argmin(grasp* g, float* elements, int n, bool* index) {
+	float min = INFINITY;
+	GRASP_FOR_CANDIDATES(g, i, n, {
+		if (elements[i] < min && index[i]) min = elements[i];
+	})
+	return min;
+}
+
+GRASP_INLINE float grasp_argmax(grasp* g, float* elements, int n, bool* index) {
+	float max = -INFINITY;
+	GRASP_FOR_CANDIDATES(g, i, n, {
+		if (elements[i] > max && index[i]) max = elements[i];
+	})
+	return max;
+}
+
+// Build a solution with the greedy randomized construction
+// compute_costs, update_candidates - the callbacks used during construction
+// costs, candidates, rcl - work buffers with room for n_elements items
+GRASP_INLINE void grasp_construct_impl(grasp* g, void* elements, const int n_elements, int* solution, int* n_solution,
+                                       float* costs, bool* candidates, int* rcl,
+                                       grasp_cost compute_costs, grasp_candidates update_candidates) {
+	// construction
+	// initialize empty solution
+	*n_solution = 0;
+	// initialize candidate list
+	for (int j = 0; j < n_elements; j++) candidates[j] = true;
+	int n_candidates = n_elements;
+	g->candidate_indices = NULL;
+	update_candidates(g, elements, n_elements, solution, *n_solution, candidates);
+
+	// compute incremental costs
+	compute_costs(g, elements, n_elements, solution, *n_solution, costs);
+
+	// construct
+	while (n_candidates != 0) {
+		float c_min = grasp_argmin(g, costs, n_elements, candidates);
+		float c_max = grasp_argmax(g, costs, n_elements, candidates);
+
+		// build restricted candidate list
+		int n_rcl = 0;
+		float base_cost = c_min + g->alpha*(c_max - c_min);
+		GRASP_FOR_CANDIDATES(g, k, n_elements, {
+			if (candidates[k] == false) continue;
+			if (g->max) {
+				if (costs[k] >= base_cost) rcl[n_rcl++] = k;
+			} else {
+				if (costs[k] <= base_cost) rcl[n_rcl++] = k;
+			}
+		})
+		// select random element from rcl
+		int element = rcl[rand() % n_rcl];
+		solution[(*n_solution)++] = element;
+
+		// update candidates and incremental costs
+		update_candidates(g, elements, n_elements, solution, *n_solution, candidates);
+		compute_costs(g, elements, n_elements, solution, *n_solution, costs);
+		n_candidates = 0;
+		GRASP_FOR_CANDIDATES(g, k, n_elements, {
+			if (candidates[k] == true) n_candidates += 1;
+		})
+	}
+}
+
+// Run the grasp algorithm with the given callbacks, see grasp_run
+GRASP_INLINE void grasp_run_impl(grasp* g, void* elements, const int n_elements, int* best_solution, int* n_best_solution,
+                                 grasp_cost compute_costs, grasp_candidates update_candidates, grasp_compare compare_solutions,
+                                 grasp_search local_search, grasp_post_construction post_construction,
+                                 grasp_evaluate evaluate_best) {
+	int* solution = malloc(n_elements*sizeof(int));
+	float* costs = malloc(n_elements*sizeof(float));
+	bool* candidates = malloc(n_elements*sizeof(bool));
+	int* rcl = malloc(n_elements*sizeof(int));
+	int n_solution = 0;
+	g->iterations_run = 0;
+	g->gap = INFINITY;
+	for (int i = 0; i < g->iterations; i++){
+		grasp_construct_impl(g, elements, n_elements, solution, &n_solution, costs, candidates, rcl, compute_costs, update_candidates);
+
+		post_construction(g, elements, n_elements, solution, n_solution);
+		local_search(g, elements, n_elements, solution, &n_solution);
+		bool first = i == 0 ? true : false;
+		compare_solutions(g, elements, solution, n_solution, best_solution, n_best_solution, first);
+		g->iterations_run = i+1;
+
+		// stop once the best solution is proven to be close enough to the bound
+		if (evaluate_best && g->gap_tolerance > 0) {
+			float best = evaluate_best(g, elements, best_solution, *n_best_solution);
+			// a zero objective is only proven optimal by a zero bound
+			if (best == 0) g->gap = g->bound == 0 ? 0 : INFINITY;
+			else g->gap = fabsf(best - g->bound)/fabsf(best);
+			if (g->gap <= g->gap_tolerance) break;
+		}
+	}
+	free(solution);
+	free(costs);
+	free(candidates);
+	free(rcl);
+}
+
+// Define a grasp_run-like function bound at compile time to the given callbacks
+// The function pointers stored in the grasp struct are ignored by it
+// name - the name of the generated function
+// element_type, data_type - the types behind the elements array and g->data
+// cost, candidates, compare, search, post, evaluate - the callbacks, in the order of the grasp struct
+// The callbacks take typed arguments: the grasp struct, then g->data as a data_type* and the elements
+// as an element_type*, followed by the remaining arguments of the matching grasp typedef, e.g.
+//   void cost(grasp* g, data_type* data, element_type* elements, int n_elements, int* solution, int n_solution, float* costs)
+// The casts are done once by the generated adapters, which are always inlined into the engine
+// together with the callbacks, so define the callbacks GRASP_INLINE (or at least static)
+// evaluate cannot be NULL here, the generated function always has an evaluate adapter
+#define GRASP_SPECIALIZE(name, element_type, data_type, cost, candidates, compare, search, post, evaluate) \
+	GRASP_INLINE void name##_cost(grasp* g, void* elements, int n_elements, int* solution, int n_solution, float* costs) { \
+		cost(g, (data_type*) g->data, (element_type*) elements, n_elements, solution, n_solution, costs); \
+	} \
+	GRASP_INLINE void name##_candidates(grasp* g, void* elements, int n_elements, int* solution, int n_solution, bool* candidate_list) { \
+		candidates(g, (data_type*) g->data, (element_type*) elements, n_elements, solution, n_solution, candidate_list); \
+	} \
+	GRASP_INLINE void name##_compare(grasp* g, void* elements, int* solution, int n_solution, int* best_solution, int* n_best_solution, bool first_solution) { \
+		compare(g, (data_type*) g->data, (element_type*) elements, solution, n_solution, best_solution, n_best_solution, first_solution); \
+	} \
+	GRASP_INLINE void name##_search(grasp* g, void* elements, int n_elements, int* solution, int* n_solution) { \
+		search(g, (data_type*) g->data, (element_type*) elements, n_elements, solution, n_solution); \
+	} \
+	GRASP_INLINE void name##_post(grasp* g, void* elements, int n_elements, int* solution, int n_solution) { \
+		post(g, (data_type*) g->data, (element_type*) elements, n_elements, solution, n_solution); \
+	} \
+	GRASP_INLINE float name##_evaluate(grasp* g, void* elements, int* best_solution, int n_best_solution) { \
+		return evaluate(g, (data_type*) g->data, (element_type*) elements, best_solution, n_best_solution); \
+	} \
+	static void name(grasp* g, element_type* elements, const int n_elements, int* best_solution, int* n_best_solution) { \
+		grasp_run_impl(g, (void*) elements, n_elements, best_solution, n_best_solution, \
+		               name##_cost, name##_candidates, name##_compare, name##_search, name##_post, name##_evaluate); \
+	}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include "grasp.h"
+#include "grasp_inline.h"
+
+// Compares the dispatch through the function pointers of grasp_run against
+// an engine specialized with GRASP_SPECIALIZE on the same callbacks.
+// The problem is a cheap ordering of points on a line. In the dense case every step
+// scans all the points, which hides most of the per-call overhead; in the window case
+// the candidates are the next few points, given as candidate_indices, so a step is O(1)
+// and the calls dominate.
+
+static void bench_costs(grasp* g, void* data, float* points, int n_points, int* solution, int n_solution, float* costs) {
+	float last = n_solution > 0 ? points[solution[n_solution-1]] : 0;
+	for (int j = 0; j < n_points; j++) {
+		float d = points[j] - last;
+		costs[j] = d < 0 ? -d : d;
+	}
+}
+
+static void bench_candidates(grasp* g, void* data, float* points, int n_points, int* solution, int n_solution, bool* candidates) {
+	if (n_solution > 0) candidates[solution[n_solution-1]] = false;
+}
+
+static void bench_compare(grasp* g, void* data, float* points, int* sol, int n_sol, int* best, int* n_best, bool first_solution) {
+	if (!first_solution && sol[0] >= best[0]) return;
+	for (int i = 0; i < n_sol; i++) best[i] = sol[i];
+	*n_best = n_sol;
+}
+
+static void bench_search(grasp* g, void* data, float* points, int n_points, int* solution, int* n_solution) {}
+
+static void bench_post_construction(grasp* g, void* data, float* points, int n_points, int* solution, int n_solution) {}
+
+// Length of the path through the points in the order of the solution
+static float bench_evaluate(grasp* g, void* data, float* points, int* best, int n_best) {
+	float length = 0;
+	for (int i = 1; i < n_best; i++) {
+		float d = points[best[i]] - points[best[i-1]];
+		length += d < 0 ? -d : d;
+	}
+	return length;
+}
+
+GRASP_SPECIALIZE(bench_grasp_run, float, void, bench_costs, bench_candidates, bench_compare, bench_search, bench_post_construction, bench_evaluate)
+
+#define WINDOW 4
+
+// The candidates of the window case: the first WINDOW points not visited yet
+typedef struct bench_window {
+	int indices[WINDOW];
+	int n_indices;
+	int next;
+} bench_window;
+
+static void window_costs(grasp* g, bench_window* window, float* points, int n_points, int* solution, int n_solution, float* costs) {
+	float last = n_solution > 0 ? points[solution[n_solution-1]] : 0;
+	for (int k = 0; k < window->n_indices; k++) {
+		float d = points[window->indices[k]] - last;
+		costs[window->indices[k]] = d < 0 ? -d : d;
+	}
+}
+
+static void window_candidates(grasp* g, bench_window* window, float* points, int n_points, int* solution, int n_solution, bool* candidates) {
+	if (n_solution == 0) {
+		for (int j = 0; j < n_points; j++) candidates[j] = false;
+		window->n_indices = 0;
+		window->next = 0;
+		while (window->n_indices < WINDOW && window->next < n_points) {
+			candidates[window->next] = true;
+			window->indices[window->n_indices++] = window->next++;
+		}
+	} else {
+		// the visited point leaves the window and the next point takes its place
+		int visited = solution[n_solution-1];
+		candidates[visited] = false;
+		for (int k = 0; k < window->n_indices; k++) {
+			if (window->indices[k] != visited) continue;
+			if (window->next < n_points) {
+				candidates[window->next] = true;
+				window->indices[k] = window->next++;
+			} else {
+				window->indices[k] = window->indices[--window->n_indices];
+			}
+			break;
+		}
+	}
+	g->candidate_indices = window->indices;
+	g->n_candidate_indices = window->n_indices;
+}
+
+static void window_compare(grasp* g, bench_window* window, float* points, int* sol, int n_sol, int* best, int* n_best, bool first_solution) {
+	bench_compare(g, window, points, sol, n_sol, best, n_best, first_solution);
+}
+
+static void window_search(grasp* g, bench_window* window, float* points, int n_points, int* solution, int* n_solution) {}
+
+static void window_post_construction(grasp* g, bench_window* window, float* points, int n_points, int* solution, int n_solution) {}
+
+// Only the first point, so that evaluating the best solution is O(1) too
+static float window_evaluate(grasp* g, bench_window* window, float* points, int* best, int n_best) {
+	return points[best[0]];
+}
+
+GRASP_SPECIALIZE(bench_window_run, float, bench_window, window_costs, window_candidates, window_compare, window_search, window_post_construction, window_evaluate)
+
+#define REPETITIONS 5
+
+// Time both engines on the same problem, g holds the adapters of the specialized run
+// so that both execute the same callbacks. The best of REPETITIONS runs is kept.
+static void bench(const char* name, grasp* g, float* points, int n, void (*specialized)(grasp*, float*, int, int*, int*)) {
+	int* best = malloc(n*sizeof(int));
+	int n_best = 0;
+	double dynamic_time = INFINITY, static_time = INFINITY;
+
+	for (int r = 0; r < REPETITIONS; r++) {
+		srand(0);
+		clock_t start = clock();
+		grasp_run(g, points, n, best, &n_best);
+		double time = (double)(clock()-start)/CLOCKS_PER_SEC;
+		if (time < dynamic_time) dynamic_time = time;
+
+		srand(0);
+		start = clock();
+		specialized(g, points, n, best, &n_best);
+		time = (double)(clock()-start)/CLOCKS_PER_SEC;
+		if (time < static_time) static_time = time;
+	}
+
+	printf("%s: elements %d, iterations %d\n", name, n, g->iterations);
+	printf("grasp_run %.5f seconds\n", dynamic_time);
+	printf("GRASP_SPECIALIZE %.5f seconds\n", static_time);
+	printf("Speedup %.2fx\n", dynamic_time/static_time);
+	free(best);
+}
+
+int main(int argc, char** argv) {
+	int n = argc > 1 ? atoi(argv[1]) : 200;
+	int iterations = argc > 2 ? atoi(argv[2]) : 500;
+	int window_n = argc > 3 ? atoi(argv[3]) : 16;
+	int window_iterations = argc > 4 ? atoi(argv[4]) : 200000;
+
+	int n_points = n > window_n ? n : window_n;
+	float* points = malloc(n_points*sizeof(float));
+	for (int i = 0; i < n_points; i++) points[i] = (float)rand()/RAND_MAX;
+
+	grasp g = {
+		.iterations = iterations,
+		.alpha = 0.1,
+		.max = false,
+		.compute_costs = bench_grasp_run_cost,
+		.compare_solutions = bench_grasp_run_compare,
+		.update_candidates = bench_grasp_run_candidates,
+		.post_construction = bench_grasp_run_post,
+		.local_search = bench_grasp_run_search,
+		.evaluate_best = bench_grasp_run_evaluate,
+		.data = NULL
+	};
+	bench("Dense", &g, points, n, bench_grasp_run);
+
+	bench_window window;
+	g = (grasp){
+		.iterations = window_iterations,
+		.alpha = 0.1,
+		.max = false,
+		.compute_costs = bench_window_run_cost,
+		.compare_solutions = bench_window_run_compare,
+		.update_candidates = bench_window_run_candidates,
+		.post_construction = bench_window_run_post,
+		.local_search = bench_window_run_search,
+		.evaluate_best = bench_window_run_evaluate,
+		.data = &window
+	};
+	bench("Window", &g, points, window_n, bench_window_run);
+
+	free(points);
+}
@@ -8,11 +8,8 @@ for alpha in "0.2" "0.4" "0.5" "0.6" "0.8"; do
     for file in cvrp/vrp-*/*.vrp; do
         echo -e "Running $file..."
         for i in 1 2 3 4 5 6 7 8; do
-            output=$( (./grasp_cvrp "$file" --alpha "$alpha" --iter 100 --satemp 1000 --saalpha 0.99;) 2>&1 )
-            time=$( (echo "$output" | grep 'Time';) 2>&1)
-            time=${time:5:7}
-            cost=$( (echo "$output" | grep 'Cost';) 2>&1)
-            cost=${cost#"Cost "}
+            output=$( (./grasp_cvrp "$file" --alpha "$alpha" --iter 100 --satemp 1000 --saalpha 0.99 --format json;) 2>&1 )
+            read -r time cost < <(echo "$output" | python3 -c 'import json, sys; out = json.load(sys.stdin); print("%.5f %.0f" % (out["time"], out["cost"]))')
             optimal=$( (cat ${file%.*}.sol | grep "Cost";) 2>&1 )
             optimal=${optimal#"Cost "}
             problem=${file##*/}
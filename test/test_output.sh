@@ -0,0 +1,156 @@
+#!/bin/bash
+# Checks the JSON and binary output formats and the --serve loop: binary responses are
+# parsed with the layout documented in cvrp/output.h and checked against the instance,
+# and a stream of valid and invalid requests must get one framed response each, in order.
+
+BIN=${BIN:-./grasp_cvrp}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+failures=0
+instance=cvrp/vrp-A/A-n32-k5.vrp
+
+fail() {
+    echo "FAIL: $1"
+    failures=$((failures+1))
+}
+
+# reader for the binary responses, imported by the checks below
+cat > "$TMP/cvrp_binary.py" <<'EOF'
+import struct
+
+# Read one response from f, None at the end of the stream
+def read_response(f):
+    header = f.read(4)
+    if not header: return None
+    size, = struct.unpack('=I', header)
+    body = f.read(size)
+    if len(body) != size: raise ValueError('truncated response')
+    magic, version, status = struct.unpack_from('=4sii', body, 0)
+    if magic != b'CVRP' or version != 3: raise ValueError('bad header %r %d' % (magic, version))
+    offset = 12
+    if status != 0:
+        length, = struct.unpack_from('=i', body, offset)
+        offset += 4
+        response = {'status': status, 'error': body[offset:offset+length].decode()}
+        offset += length
+    else:
+        n_routes, iterations, feasible, cost, objective, time_warp, bound, gap, time = struct.unpack_from('=3i5fd', body, offset)
+        offset += struct.calcsize('=3i5fd')
+        routes = []
+        for _ in range(n_routes):
+            length, load, route_cost, route_warp = struct.unpack_from('=2i2f', body, offset)
+            offset += struct.calcsize('=2i2f')
+            stops = list(struct.unpack_from('=%di' % length, body, offset))
+            offset += 4*length
+            routes.append({'load': load, 'cost': route_cost, 'time_warp': route_warp, 'stops': stops})
+        response = {'status': 0, 'iterations': iterations, 'feasible': bool(feasible), 'cost': cost,
+                    'objective': objective, 'time_warp': time_warp, 'bound': bound, 'gap': gap,
+                    'time': time, 'routes': routes}
+    if offset != size: raise ValueError('size is %d, the fields take %d bytes' % (size, offset))
+    return response
+EOF
+
+# binary solution: every field is read back and checked against the instance
+"$BIN" "$instance" --iter 5 --gap 0.01 --format binary > "$TMP/out.bin"
+PYTHONPATH="$TMP" python3 - "$instance" "$TMP/out.bin" <<'EOF' || fail "binary solution"
+import sys, math
+from cvrp_binary import read_response
+
+lines = [l.split() for l in open(sys.argv[1]).read().split('\n')]
+def section(name, n):
+    start = next(i for i, l in enumerate(lines) if l and l[0] == name)
+    return [[float(v) for v in l[1:]] for l in lines[start+1:start+1+n]]
+n = int(next(l for l in lines if l and l[0] == 'DIMENSION')[2])
+coords = section('NODE_COORD_SECTION', n)
+demands = [int(d[0]) for d in section('DEMAND_SECTION', n)]
+def distance(a, b):
+    return math.hypot(coords[a][0]-coords[b][0], coords[a][1]-coords[b][1])
+
+f = open(sys.argv[2], 'rb')
+out = read_response(f)
+errors = []
+if f.read(): errors.append('bytes after the response')
+def close(a, b): return abs(a - b) <= 0.01 + 1e-4*abs(b)
+
+if out['status'] != 0: errors.append('status %d' % out['status'])
+else:
+    routes = out['routes']
+    if len(routes) != 5: errors.append('%d routes' % len(routes))
+    if sorted(s for r in routes for s in r['stops']) != list(range(1, n)): errors.append('every customer must be visited once')
+    total = 0
+    for i, route in enumerate(routes):
+        stops = route['stops']
+        cost = sum(distance(a, b) for a, b in zip([0]+stops, stops+[0])) if stops else 0
+        if route['load'] != sum(demands[s] for s in stops): errors.append('route %d load' % (i+1))
+        if not close(route['cost'], cost): errors.append('route %d cost %.2f, expected %.2f' % (i+1, route['cost'], cost))
+        total += cost
+    if not close(out['cost'], total): errors.append('cost %.2f, expected %.2f' % (out['cost'], total))
+    if not close(out['objective'], total): errors.append('objective of a plain instance is the cost')
+    if not 1 <= out['iterations'] <= 5: errors.append('iterations %d' % out['iterations'])
+    if math.isnan(out['bound']) or out['bound'] > out['cost']: errors.append('bound %f' % out['bound'])
+    if not close(out['gap'], (out['cost'] - out['bound'])/out['cost']): errors.append('gap %f' % out['gap'])
+
+for e in errors: print('binary: ' + e)
+sys.exit(1 if errors else 0)
+EOF
+
+# binary error: the message follows the status
+"$BIN" "$TMP/missing.vrp" --format binary > "$TMP/out.bin"
+PYTHONPATH="$TMP" python3 - "$TMP/out.bin" "$TMP/missing.vrp" <<'EOF' || fail "binary error"
+import sys
+from cvrp_binary import read_response
+out = read_response(open(sys.argv[1], 'rb'))
+expected = 'Invalid file "%s"' % sys.argv[2]
+if out['status'] != 1 or out['error'] != expected:
+    print('binary error: %r' % out)
+    sys.exit(1)
+EOF
+
+# the same stream of requests is served in both formats: valid, missing value,
+# missing file, text format, blank line (skipped) and valid again
+requests() {
+    echo "$instance --iter 2"
+    echo "$instance --iter"
+    echo "$TMP/missing.vrp --iter 2"
+    echo "$instance --iter 2 --format text"
+    echo ""
+    echo "$instance --iter 3 --alpha 0.3"
+}
+
+requests | "$BIN" --serve > "$TMP/serve.json"
+python3 - "$TMP/serve.json" <<'EOF' || fail "json serve"
+import sys, json
+responses = [json.loads(l) for l in open(sys.argv[1])]
+kinds = ['error' if 'error' in r else 'solution' for r in responses]
+if kinds != ['solution', 'error', 'error', 'error', 'solution']:
+    print('json serve: responses %s' % kinds)
+    sys.exit(1)
+if responses[1]['error'] != 'Missing value for "--iter"' or responses[4]['iterations'] != 3:
+    print('json serve: %r' % responses)
+    sys.exit(1)
+EOF
+
+requests | "$BIN" --serve --format binary > "$TMP/serve.bin"
+PYTHONPATH="$TMP" python3 - "$TMP/serve.bin" <<'EOF' || fail "binary serve"
+import sys
+from cvrp_binary import read_response
+f = open(sys.argv[1], 'rb')
+responses = []
+while True:
+    response = read_response(f)
+    if response is None: break
+    responses.append(response)
+statuses = [r['status'] for r in responses]
+if statuses != [0, 1, 1, 1, 0] or responses[4]['iterations'] != 3:
+    print('binary serve: statuses %s' % statuses)
+    sys.exit(1)
+EOF
+
+# text responses would have no delimiter
+"$BIN" --serve --format text < /dev/null > /dev/null && fail "--serve --format text was accepted"
+
+if [ $failures -ne 0 ]; then
+    echo "$failures checks failed"
+    exit 1
+fi
+echo "output: all checks passed"
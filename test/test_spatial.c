@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "spatial.h"
+
+// Checks the grid queries against a brute force scan over the same points,
+// with part of the points removed and after putting them back with cvrp_grid_reset.
+
+#define N_NODES 500
+#define N_QUERIES 200
+#define K 10
+
+static int failures = 0;
+
+static long squared_distance(cvrp_node node, int x, int y) {
+    long dx = node.x - x;
+    long dy = node.y - y;
+    return dx*dx + dy*dy;
+}
+
+static void check(bool ok, const char* what, int query) {
+    if (ok) return;
+    printf("FAIL: %s (query %d)\n", what, query);
+    failures++;
+}
+
+// Distances of the k nearest alive points, found by sorting every alive point
+static int brute_knearest(cvrp_node* nodes, bool* alive, int x, int y, int k, long* out) {
+    int n_found = 0;
+    for (int i = 0; i < N_NODES; i++) {
+        if (!alive[i]) continue;
+        long distance = squared_distance(nodes[i], x, y);
+        if (n_found == k && distance >= out[k-1]) continue;
+        int j = n_found < k ? n_found++ : k-1;
+        for (; j > 0 && out[j-1] > distance; j--) out[j] = out[j-1];
+        out[j] = distance;
+    }
+    return n_found;
+}
+
+static void check_queries(cvrp_grid* grid, cvrp_node* nodes, bool* alive) {
+    for (int q = 0; q < N_QUERIES; q++) {
+        // some queries fall outside the bounding box of the points
+        int x = rand() % 1200 - 100;
+        int y = rand() % 1200 - 100;
+
+        long expected[K];
+        int n_expected = brute_knearest(nodes, alive, x, y, K, expected);
+
+        int found[K];
+        int n_found = cvrp_grid_knearest(grid, x, y, K, found);
+        check(n_found == n_expected, "knearest count", q);
+        for (int i = 0; i < n_found && i < n_expected; i++) {
+            check(alive[found[i]], "knearest returned a removed point", q);
+            // ties may be broken differently, so compare the distances
+            check(squared_distance(nodes[found[i]], x, y) == expected[i], "knearest distance", q);
+        }
+
+        int nearest = cvrp_grid_nearest(grid, x, y);
+        if (n_expected == 0) check(nearest == -1, "nearest on empty grid", q);
+        else check(squared_distance(nodes[nearest], x, y) == expected[0], "nearest distance", q);
+
+        float radius = rand() % 150;
+        int in_radius[N_NODES];
+        int n_radius = cvrp_grid_radius(grid, x, y, radius, in_radius);
+        bool seen[N_NODES] = {false};
+        for (int i = 0; i < n_radius; i++) {
+            check(alive[in_radius[i]], "radius returned a removed point", q);
+            check(!seen[in_radius[i]], "radius returned a point twice", q);
+            seen[in_radius[i]] = true;
+        }
+        int n_brute = 0;
+        for (int i = 0; i < N_NODES; i++) {
+            if (alive[i] && squared_distance(nodes[i], x, y) <= (double)radius*radius) {
+                n_brute++;
+                check(seen[i], "radius missed a point", q);
+            }
+        }
+        check(n_radius == n_brute, "radius count", q);
+    }
+}
+
+int main() {
+    srand(42);
+
+    cvrp_node nodes[N_NODES];
+    bool alive[N_NODES];
+    for (int i = 0; i < N_NODES; i++) {
+        // clustered points, with duplicates, so some cells are much fuller than others
+        int cluster = i % 4;
+        nodes[i] = (cvrp_node){.x = cluster*250 + rand() % (cluster == 0 ? 1000 : 60), .y = rand() % 1000};
+        alive[i] = true;
+    }
+    nodes[1] = nodes[0];
+
+    cvrp_grid* grid = cvrp_grid_create(nodes, NULL, N_NODES, N_NODES);
+    check_queries(grid, nodes, alive);
+
+    // remove nodes one by one, the way the construction visits them
+    for (int removed = 0; removed < N_NODES; removed++) {
+        int index = rand() % N_NODES;
+        cvrp_grid_remove(grid, index);
+        alive[index] = false;
+        if (removed % 100 == 0) check_queries(grid, nodes, alive);
+    }
+
+    // remove everything that is left
+    for (int i = 0; i < N_NODES; i++) {
+        cvrp_grid_remove(grid, i);
+        alive[i] = false;
+    }
+    check_queries(grid, nodes, alive);
+
+    cvrp_grid_reset(grid);
+    for (int i = 0; i < N_NODES; i++) alive[i] = true;
+    check_queries(grid, nodes, alive);
+    cvrp_grid_free(grid);
+
+    // grid over a subset of the nodes
+    int indices[N_NODES/2];
+    for (int i = 0; i < N_NODES; i++) alive[i] = i % 2 == 1;
+    for (int i = 0; i < N_NODES/2; i++) indices[i] = 2*i + 1;
+    grid = cvrp_grid_create(nodes, indices, N_NODES/2, N_NODES);
+    check_queries(grid, nodes, alive);
+    cvrp_grid_free(grid);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("spatial: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+#!/bin/bash
+# Checks the heterogeneous fleet and time window instances under cvrp/variants:
+# the JSON output is checked against loads, costs and time warps recomputed here,
+# and instances with malformed optional sections must be rejected with an error.
+
+BIN=${BIN:-./grasp_cvrp}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL: $1"
+    failures=$((failures+1))
+}
+
+# same instance with windows too tight to meet, so that the time warp is not zero
+python3 - cvrp/variants/A-n32-k5-tw.vrp "$TMP/A-n32-k5-tight.vrp" <<'EOF'
+import sys
+lines = open(sys.argv[1]).read().split('\n')
+start = lines.index('TIME_WINDOW_SECTION')
+for i in range(start+2, start+33):
+    node, ready, due, service = lines[i].split()
+    lines[i] = ' %s %s %d %s' % (node, ready, int(ready)+5, service)
+open(sys.argv[2], 'w').write('\n'.join(lines))
+EOF
+
+for file in cvrp/variants/*.vrp "$TMP/A-n32-k5-tight.vrp"; do
+    "$BIN" "$file" --iter 20 --format json > "$TMP/out.json"
+    python3 - "$file" "$TMP/out.json" <<'EOF' || fail "$file"
+import sys, json, math
+
+lines = [l.split() for l in open(sys.argv[1]).read().split('\n')]
+def section(name, n):
+    start = next(i for i, l in enumerate(lines) if l and l[0] == name)
+    return [[float(v) for v in l[1:]] for l in lines[start+1:start+1+n]]
+
+name = next(l for l in lines if l and l[0] == 'NAME')[2]
+n = int(next(l for l in lines if l and l[0] == 'DIMENSION')[2])
+cap = int(next(l for l in lines if l and l[0] == 'CAPACITY')[2])
+k = int(name.split('-k')[1].split('-')[0])
+coords = section('NODE_COORD_SECTION', n)
+demands = [int(d[0]) for d in section('DEMAND_SECTION', n)]
+caps = [int(c[0]) for c in section('VEHICLE_CAPACITY_SECTION', k)] if ['VEHICLE_CAPACITY_SECTION'] in lines else [cap]*k
+windows = section('TIME_WINDOW_SECTION', n) if ['TIME_WINDOW_SECTION'] in lines else None
+
+def distance(a, b):
+    return math.hypot(coords[a][0]-coords[b][0], coords[a][1]-coords[b][1])
+
+# time warp as in the segment evaluation: arriving late costs the delay and the service starts at the due time
+def time_warp(stops):
+    if not windows or not stops: return 0
+    time, warp, last = windows[0][0], 0, 0
+    for node in stops + [0]:
+        time += windows[last][2] + distance(last, node)
+        ready, due = windows[node][0], windows[node][1]
+        if time < ready: time = ready
+        if time > due:
+            warp += time - due
+            time = due
+        last = node
+    return warp
+
+out = json.load(open(sys.argv[2]))
+errors = []
+def close(a, b): return abs(a - b) <= 0.01 + 1e-4*abs(b)
+
+routes = out['routes']
+if len(routes) != k: errors.append('expected %d routes' % k)
+visited = sorted(s for r in routes for s in r['stops'])
+if visited != list(range(1, n)): errors.append('every customer must be visited once')
+
+total_cost, total_warp, total_excess, feasible = 0, 0, 0, True
+for i, route in enumerate(routes):
+    # stops are numbered as in the .sol files, customer s is the row s+1 of the sections
+    stops = route['stops']
+    load = sum(demands[s] for s in stops)
+    cost = sum(distance(a, b) for a, b in zip([0]+stops, stops+[0])) if stops else 0
+    warp = time_warp(stops)
+    if route['load'] != load: errors.append('route %d load %d, expected %d' % (i+1, route['load'], load))
+    if not close(route['cost'], cost): errors.append('route %d cost %.2f, expected %.2f' % (i+1, route['cost'], cost))
+    if not close(route['time_warp'], warp): errors.append('route %d time warp %.2f, expected %.2f' % (i+1, route['time_warp'], warp))
+    feasible = feasible and load <= caps[i] and warp < 1e-3
+    total_cost += cost
+    total_warp += warp
+    total_excess += max(load - caps[i], 0)
+
+if not close(out['cost'], total_cost): errors.append('cost %.2f, expected %.2f' % (out['cost'], total_cost))
+if not close(out['time_warp'], total_warp): errors.append('time warp %.2f, expected %.2f' % (out['time_warp'], total_warp))
+objective = total_cost + 100*total_warp + 100*total_excess
+if not close(out['objective'], objective): errors.append('objective %.2f, expected %.2f' % (out['objective'], objective))
+if out['feasible'] != feasible: errors.append('feasible is %s' % out['feasible'])
+
+for e in errors: print(sys.argv[1] + ': ' + e)
+sys.exit(1 if errors else 0)
+EOF
+done
+
+# fleet whose capacities leave little slack: every run must end with each route within its vehicle
+python3 - cvrp/variants/A-n32-k5-hf.vrp "$TMP/A-n32-k5-hf-tight.vrp" <<'EOF'
+import sys
+lines = open(sys.argv[1]).read().split('\n')
+start = lines.index('VEHICLE_CAPACITY_SECTION')
+for i, cap in enumerate([100, 100, 90, 70, 60]):
+    lines[start+1+i] = ' %d %d' % (i+1, cap)
+open(sys.argv[2], 'w').write('\n'.join(lines))
+EOF
+for run in 1 2 3 4 5; do
+    "$BIN" "$TMP/A-n32-k5-hf-tight.vrp" --iter 30 --format json > "$TMP/out.json"
+    grep -q '"feasible":true' "$TMP/out.json" || fail "A-n32-k5-hf-tight run $run is not feasible"
+done
+
+# windows and a first vehicle that takes every customer at the split: the windows can only
+# be met once customers move onto the vehicles left empty
+python3 - cvrp/variants/A-n32-k5-tw.vrp "$TMP/A-n32-k5-tw-fleet.vrp" <<'EOF'
+import sys
+lines = open(sys.argv[1]).read().rstrip('\n').split('\n')
+if lines[-1].strip() == 'EOF': lines.pop()
+lines += ['VEHICLE_CAPACITY_SECTION'] + [' %d %d' % (i+1, cap) for i, cap in enumerate([410, 100, 100, 100, 100])] + ['EOF']
+open(sys.argv[2], 'w').write('\n'.join(lines) + '\n')
+EOF
+"$BIN" "$TMP/A-n32-k5-tw-fleet.vrp" --iter 10 --format json > "$TMP/out.json"
+grep -q '"feasible":true' "$TMP/out.json" || fail "A-n32-k5-tw-fleet is not feasible"
+
+# malformed optional sections: name, file to edit, python edit of its lines
+bad_instance() {
+    python3 - "$2" "$TMP/$1.vrp" "$3" <<'EOF'
+import sys
+lines = open(sys.argv[1]).read().split('\n')
+exec(sys.argv[3])
+open(sys.argv[2], 'w').write('\n'.join(lines))
+EOF
+    "$BIN" "$TMP/$1.vrp" --iter 1 --format json > "$TMP/out.json"
+    grep -q '"error"' "$TMP/out.json" || fail "$1 was not rejected"
+    [ -n "$VERBOSE" ] && cat "$TMP/out.json"
+}
+
+s='lines.index("VEHICLE_CAPACITY_SECTION")'
+bad_instance missing_capacity cvrp/variants/A-n32-k5-hf.vrp "del lines[$s+5]"
+bad_instance extra_capacity cvrp/variants/A-n32-k5-hf.vrp "lines.insert($s+6, ' 6 100')"
+bad_instance unnumbered_capacity cvrp/variants/A-n32-k5-hf.vrp "lines[$s+1] = ' 140'"
+s='lines.index("TIME_WINDOW_SECTION")'
+bad_instance missing_window cvrp/variants/A-n32-k5-tw.vrp "del lines[$s+32]"
+bad_instance extra_window cvrp/variants/A-n32-k5-tw.vrp "lines.insert($s+33, ' 33 0 100 10')"
+bad_instance short_window cvrp/variants/A-n32-k5-tw.vrp "lines[$s+5] = ' 5 10 20'"
+bad_instance inverted_window cvrp/variants/A-n32-k5-tw.vrp "lines[$s+5] = ' 5 20 10 10'"
+
+if [ $failures -ne 0 ]; then
+    echo "$failures checks failed"
+    exit 1
+fi
+echo "variants: all checks passed"